@@ -0,0 +1,135 @@
+// Sensor recording decoder
+//
+// Turns the blocks of the worker's sensor recorder (a DataLogging session, see recorder.h) back
+// into a trace the replay tool reads: one a or c record per sample, sorted by time. Compass
+// readings of invalid data are dropped, like the lap detection does.
+//
+// Usage: decode recording > trace.csv
+
+#include <pebble.h>
+#include <recorder.h>
+
+typedef struct {
+  int64_t t;
+  char type;
+  int32_t v[3];
+  bool vib;
+  long order;   // keeps the recording order of equal times
+} Sample;
+
+static Sample *samples = NULL;
+static long samples_cnt = 0;
+static long samples_cap = 0;
+
+static uint32_t read_varint(const uint8_t **p, const uint8_t *end) {
+  uint32_t value = 0;
+  int shift = 0;
+  while (*p < end) {
+    uint8_t b = *(*p)++;
+    value |= (uint32_t)(b & 0x7f) << shift;
+    if (!(b & 0x80)) {
+      break;
+    }
+    shift += 7;
+  }
+  return value;
+}
+
+static int32_t unzigzag(uint32_t value) {
+  return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static Sample *add_sample() {
+  if (samples_cnt == samples_cap) {
+    samples_cap = samples_cap ? samples_cap * 2 : 4096;
+    samples = realloc(samples, samples_cap * sizeof(Sample));
+    if (!samples) {
+      perror("realloc");
+      exit(2);
+    }
+  }
+  Sample *s = &samples[samples_cnt];
+  s->order = samples_cnt++;
+  return s;
+}
+
+// Decode a block, returns false if it is not one of ours
+static bool decode_block(const uint8_t *block) {
+  const uint8_t *p = block + RECORDER_HEADER_SIZE;
+  const uint8_t *end = block + RECORDER_BLOCK_SIZE;
+  int64_t t = 0;
+  int32_t x = 0, y = 0, z = 0, heading = 0;
+
+  if (block[0] != RECORDER_VERSION) {
+    return false;
+  }
+  for (int i = 0; i < 8; i++) {
+    t |= (int64_t)block[1 + i] << (8 * i);
+  }
+
+  while (p < end && *p != RECORDER_END) {
+    uint8_t tag = *p++;
+    t += unzigzag(read_varint(&p, end));
+
+    if ((tag & 0x0f) == RECORDER_ACCEL) {
+      x += unzigzag(read_varint(&p, end));
+      y += unzigzag(read_varint(&p, end));
+      z += unzigzag(read_varint(&p, end));
+      Sample *s = add_sample();
+      *s = (Sample) { .t = t, .type = 'a', .v = { x, y, z }, .vib = tag & RECORDER_VIBRATE, .order = s->order };
+    } else if ((tag & 0x0f) == RECORDER_COMPASS) {
+      heading += unzigzag(read_varint(&p, end));
+      if ((tag >> RECORDER_STATUS_SHIFT) != CompassStatusDataInvalid) {
+        Sample *s = add_sample();
+        *s = (Sample) { .t = t, .type = 'c', .v = { heading }, .order = s->order };
+      }
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+static int compare_samples(const void *a, const void *b) {
+  const Sample *sa = a, *sb = b;
+  if (sa->t != sb->t) {
+    return sa->t < sb->t ? -1 : 1;
+  }
+  return sa->order < sb->order ? -1 : 1;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s recording > trace.csv\n", argv[0]);
+    return 2;
+  }
+  FILE *f = fopen(argv[1], "rb");
+  if (!f) {
+    perror(argv[1]);
+    return 2;
+  }
+
+  uint8_t block[RECORDER_BLOCK_SIZE];
+  long blocks = 0, bad = 0;
+  while (fread(block, RECORDER_BLOCK_SIZE, 1, f) == 1) {
+    blocks++;
+    if (!decode_block(block)) {
+      bad++;
+    }
+  }
+  fclose(f);
+
+  // Compass readings come between the accelerometer batches, which cover the second before
+  qsort(samples, samples_cnt, sizeof(Sample), compare_samples);
+
+  printf("# decode %s, %ld blocks (%ld bad)\n", argv[1], blocks, bad);
+  for (long i = 0; i < samples_cnt; i++) {
+    Sample *s = &samples[i];
+    if (s->type == 'a') {
+      printf("a,%lld,%d,%d,%d%s\n", (long long)s->t, s->v[0], s->v[1], s->v[2], s->vib ? ",1" : "");
+    } else {
+      printf("c,%lld,%d\n", (long long)s->t, (int)((s->v[0] * 360 + TRIG_MAX_ANGLE / 2) / TRIG_MAX_ANGLE) % 360);
+    }
+  }
+  return bad ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+// Host stub of the Pebble SDK header
+//
+// Just enough of <pebble.h> to compile the sensor detection code (strokes.c, laps.c, common.c)
+// and the sensor recorder on the host. The time and DataLogging functions are implemented by the
+// replay tool, which drives the clock from the trace timestamps.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Logging
+typedef enum {
+  APP_LOG_LEVEL_ERROR = 1,
+  APP_LOG_LEVEL_WARNING = 50,
+  APP_LOG_LEVEL_INFO = 100,
+  APP_LOG_LEVEL_DEBUG = 200,
+  APP_LOG_LEVEL_DEBUG_VERBOSE = 255,
+} AppLogLevel;
+
+#define APP_LOG(level, fmt, ...) \
+  fprintf(stderr, "[%d] " fmt "\n", (int)(level), ##__VA_ARGS__)
+
+// Time
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms);
+bool clock_is_24h_style(void);
+
+// Trigonometry
+#define TRIG_MAX_RATIO 0xffff
+#define TRIG_MAX_ANGLE 0x10000
+#define TRIGANGLE_TO_DEG(trig_angle) (((trig_angle) * 360) / TRIG_MAX_ANGLE)
+#define DEG_TO_TRIGANGLE(angle) (((angle) * TRIG_MAX_ANGLE) / 360)
+
+static inline int32_t sin_lookup(int32_t angle) {
+  return (int32_t)lround(sin(angle * 2 * M_PI / TRIG_MAX_ANGLE) * TRIG_MAX_RATIO);
+}
+
+static inline int32_t cos_lookup(int32_t angle) {
+  return (int32_t)lround(cos(angle * 2 * M_PI / TRIG_MAX_ANGLE) * TRIG_MAX_RATIO);
+}
+
+// Accelerometer
+typedef enum {
+  ACCEL_SAMPLING_10HZ = 10,
+  ACCEL_SAMPLING_25HZ = 25,
+  ACCEL_SAMPLING_50HZ = 50,
+  ACCEL_SAMPLING_100HZ = 100,
+} AccelSamplingRate;
+
+typedef struct __attribute__((__packed__)) {
+  int16_t x;
+  int16_t y;
+  int16_t z;
+  bool did_vibrate;
+  uint64_t timestamp;
+} AccelData;
+
+// Compass
+typedef int32_t CompassHeading;
+
+typedef enum {
+  CompassStatusUnavailable = -1,
+  CompassStatusDataInvalid = 0,
+  CompassStatusCalibrating,
+  CompassStatusCalibrated
+} CompassStatus;
+
+typedef struct {
+  CompassHeading magnetic_heading;
+  CompassHeading true_heading;
+  CompassStatus compass_status;
+  bool is_declination_valid;
+} CompassHeadingData;
+
+// DataLogging
+typedef void *DataLoggingSessionRef;
+
+typedef enum {
+  DATA_LOGGING_BYTE_ARRAY = 0,
+  DATA_LOGGING_UINT = 2,
+  DATA_LOGGING_INT = 3,
+} DataLoggingItemType;
+
+typedef enum {
+  DATA_LOGGING_SUCCESS = 0,
+  DATA_LOGGING_BUSY,
+  DATA_LOGGING_FULL,
+  DATA_LOGGING_NOT_FOUND,
+  DATA_LOGGING_CLOSED,
+  DATA_LOGGING_INVALID_PARAMS,
+} DataLoggingResult;
+
+DataLoggingSessionRef data_logging_create(uint32_t tag, DataLoggingItemType item_type, uint16_t item_length,
+                                          bool resume);
+void data_logging_finish(DataLoggingSessionRef logging_session);
+DataLoggingResult data_logging_log(DataLoggingSessionRef logging_session, const void *data, uint32_t num_items);
\ No newline at end of file
@@ -0,0 +1,3 @@
+// Host stand-in for the worker SDK header, the worker API used by the detectors is the same as the app one
+
+#include <pebble.h>
\ No newline at end of file
@@ -0,0 +1,537 @@
+// Sensor trace replay tool
+//
+// Replays a recorded or synthetic accelerometer & compass trace through the stroke and lap
+// detectors of the watchapp, faster than real time, and reports the detected counts against
+// the ground truth of the trace as well as the detectors' throughput.
+//
+// Trace format (CSV, one record per line, sorted by time, '#' starts a comment):
+//   a,<t_ms>,<x>,<y>,<z>[,<did_vibrate>]   accelerometer sample in mg
+//   c,<t_ms>,<heading>                      compass true heading in degrees
+//   S,<t_ms>                                ground truth: an arm stroke
+//   L,<t_ms>                                ground truth: a wall turn (a new lap)
+//   R,<t_ms>                                ground truth: the swimmer rests at the wall
+//
+// Usage: replay [-n repeats] [-s max_stroke_error_%] [-l max_lap_error] [-R] [-r recording] trace.csv
+// With -s or -l the exit status is 1 when the detected counts are off by more than that. With -R it is
+// also 1 when the rests detected are not the real ones, or when the counts after the first rest are
+// off (the worker must resume on the push-off).
+// With -r the samples the worker sees are also recorded like its DataLogging session does (see
+// recorder.c), into the given file; decode turns such a file back into a trace.
+
+#include <pebble.h>
+#include <sensing.h>
+#include <strokes.h>
+#include <stroketype.h>
+#include <tempo.h>
+#include <laps.h>
+#include <turns.h>
+#include <schedule.h>
+#include <rest.h>
+#include <recorder.h>
+#include <unistd.h>
+
+#define LAP_MATCH_MS 20000 // a detected lap further than this from a real turn is a false one
+#define TAP_MG 1000        // sample to sample change of an axis that fires the accelerometer tap service
+
+typedef struct {
+  char type;
+  uint64_t t;
+  int16_t v[3];
+  bool vib;
+} Record;
+
+static Record *records = NULL;
+static int records_cnt = 0;
+
+static AccelData *accel = NULL;
+static int accel_cnt = 0;
+static CompassHeadingData *compass = NULL;
+static uint64_t *compass_t = NULL;
+static int compass_cnt = 0;
+
+static int truth_strokes = 0;
+static int type_strokes[STROKE_TYPES]; // detected, by stroke type
+static const char *type_names[STROKE_TYPES] = { "unknown", "free", "back", "breast", "fly" };
+static double tempo_strokes = 0;     // the stroke rate integrated over the batches
+static double tempo_rate_sum = 0;    // of the rates while swimming
+static int tempo_rates = 0;
+static uint64_t *truth_laps_t = NULL;
+static int truth_laps = 0;
+static uint64_t *truth_rests_t = NULL;
+static int truth_rests = 0;
+static int truth_strokes_after = 0; // of the first rest
+
+// Replay clock, follows the timestamps of the trace
+static uint64_t now_ms = 0;
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms) {
+  if (tloc) {
+    *tloc = (time_t)(now_ms / 1000);
+  }
+  if (out_ms) {
+    *out_ms = (uint16_t)(now_ms % 1000);
+  }
+  return (uint16_t)(now_ms % 1000);
+}
+
+bool clock_is_24h_style(void) {
+  return true;
+}
+
+// DataLogging session of the recorder, written to a file
+static FILE *record_file = NULL;
+static long record_items = 0;
+static uint16_t record_item_length = 0;
+
+DataLoggingSessionRef data_logging_create(uint32_t tag, DataLoggingItemType item_type, uint16_t item_length,
+                                          bool resume) {
+  record_item_length = item_length;
+  return record_file;
+}
+
+void data_logging_finish(DataLoggingSessionRef logging_session) {
+}
+
+DataLoggingResult data_logging_log(DataLoggingSessionRef logging_session, const void *data, uint32_t num_items) {
+  fwrite(data, record_item_length, num_items, logging_session);
+  record_items += num_items;
+  return DATA_LOGGING_SUCCESS;
+}
+
+static double seconds_now() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *grow(void *p, int cnt, size_t size) {
+  // Double the capacity whenever the count reaches a power of 2
+  if (cnt == 0 || (cnt & (cnt - 1)) == 0) {
+    p = realloc(p, (cnt ? cnt * 2 : 1024) * size);
+    if (!p) {
+      perror("realloc");
+      exit(2);
+    }
+  }
+  return p;
+}
+
+static void load_trace(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    perror(path);
+    exit(2);
+  }
+
+  char line[128];
+  int line_no = 0;
+  while (fgets(line, sizeof(line), f)) {
+    line_no++;
+    if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') {
+      continue;
+    }
+
+    Record r = { .type = line[0] };
+    unsigned long long t = 0;
+    int x = 0, y = 0, z = 0, vib = 0;
+    int n = sscanf(line + 1, ",%llu,%d,%d,%d,%d", &t, &x, &y, &z, &vib);
+    r.t = t;
+    switch (r.type) {
+      case 'a':
+        if (n < 4) goto bad;
+        r.v[0] = x; r.v[1] = y; r.v[2] = z; r.vib = vib;
+        break;
+      case 'c':
+        if (n < 2) goto bad;
+        r.v[0] = ((x % 360) + 360) % 360;
+        break;
+      case 'S':
+      case 'L':
+      case 'R':
+        if (n < 1) goto bad;
+        break;
+      default:
+        goto bad;
+    }
+    records = grow(records, records_cnt, sizeof(Record));
+    records[records_cnt++] = r;
+    continue;
+
+  bad:
+    fprintf(stderr, "%s:%d: bad record\n", path, line_no);
+    exit(2);
+  }
+  fclose(f);
+
+  // Split the trace into the per sensor streams used by the throughput runs
+  for (int i = 0; i < records_cnt; i++) {
+    Record *r = &records[i];
+    if (r->type == 'a') {
+      accel = grow(accel, accel_cnt, sizeof(AccelData));
+      accel[accel_cnt++] = (AccelData) {
+        .x = r->v[0], .y = r->v[1], .z = r->v[2], .did_vibrate = r->vib, .timestamp = r->t
+      };
+    } else if (r->type == 'c') {
+      int32_t heading = DEG_TO_TRIGANGLE(r->v[0]);
+      compass = grow(compass, compass_cnt, sizeof(CompassHeadingData));
+      compass_t = grow(compass_t, compass_cnt, sizeof(uint64_t));
+      compass_t[compass_cnt] = r->t;
+      compass[compass_cnt++] = (CompassHeadingData) {
+        .magnetic_heading = heading, .true_heading = heading, .compass_status = CompassStatusCalibrated
+      };
+    } else if (r->type == 'S') {
+      truth_strokes++;
+      truth_strokes_after += truth_rests > 0;
+    } else if (r->type == 'L') {
+      truth_laps_t = grow(truth_laps_t, truth_laps, sizeof(uint64_t));
+      truth_laps_t[truth_laps++] = r->t;
+    } else if (r->type == 'R') {
+      truth_rests_t = grow(truth_rests_t, truth_rests, sizeof(uint64_t));
+      truth_rests_t[truth_rests++] = r->t;
+    }
+  }
+}
+
+// Lap bookkeeping of the replay, like count_lap() in the worker
+static int laps = 0;
+static int rests = 0;  // stillness detections, a swim without rests should have none
+static int64_t lap_start = 0;
+static int strokes_after = 0;   // detected after the first rest
+static uint64_t resumed_t = 0;  // end of the first rest, 0 before
+
+// The push-off after a rest fires the tap service: a large change of an axis between two samples
+static bool tap_detect(const AccelData *previous, const AccelData *sample) {
+  return abs(sample->x - previous->x) > TAP_MG || abs(sample->y - previous->y) > TAP_MG ||
+         abs(sample->z - previous->z) > TAP_MG;
+}
+
+static void lap_counted(int64_t turn_time, uint64_t *laps_t, uint64_t *confirm_t) {
+  schedule_lap(turn_time - lap_start);
+  lap_start = turn_time;
+  confirm_t[laps] = now_ms;
+  laps_t[laps++] = turn_time;
+}
+
+// Replay the trace in time order, the way the watch delivers it: accelerometer samples in batches
+// of ACCEL_SAMPLES_PER_CALLBACK and compass readings one by one while the compass schedule has it on.
+// During a rest only the tap service is on, like in the worker (see ubiswim_worker.c).
+// Stores the time of each lap (the turn) and the time it was confirmed (the callback that counted it).
+// Returns the number of laps and sets compass_on_ms to the time the compass was on.
+static int replay_detect(int *strokes, uint64_t *laps_t, uint64_t *confirm_t, uint64_t *compass_on_ms) {
+  AccelData batch[ACCEL_SAMPLES_PER_CALLBACK];
+  int batch_cnt = 0;
+  int a = 0, c = 0;
+  int64_t push_time, turn_time;
+  bool compass_on = true;
+  uint64_t compass_on_since = records_cnt ? records[0].t : 0;
+  bool resting = false;
+  int64_t rest_time = 0;
+
+  strokes_reset();
+  turns_reset();
+  laps_reset();
+  schedule_reset();
+  rest_reset();
+  rests = 0;
+  *strokes = 0;
+  memset(type_strokes, 0, sizeof(type_strokes));
+  tempo_reset();
+  tempo_strokes = 0;
+  tempo_rate_sum = 0;
+  tempo_rates = 0;
+  *compass_on_ms = 0;
+  laps = 0;
+  lap_start = compass_on_since;
+  strokes_after = 0;
+  resumed_t = 0;
+
+  while (a < accel_cnt || c < compass_cnt) {
+    bool flush = false;
+
+    if (resting) {
+      // Sensors off until the push-off, which moves the lap start past the rest
+      if (c < compass_cnt && (a >= accel_cnt || compass_t[c] < accel[a].timestamp)) {
+        c++;
+      } else if (a > 0 && tap_detect(&accel[a - 1], &accel[a])) {
+        now_ms = accel[a].timestamp;
+        resting = false;
+        lap_start += now_ms - rest_time;
+        strokes_reset();
+        turns_reset();
+        rest_reset();
+        tempo_reset();
+        compass_on = true;
+        compass_on_since = now_ms;
+        if (resumed_t == 0) {
+          resumed_t = now_ms;
+        }
+      } else {
+        a++;
+      }
+      continue;
+    }
+
+    if (c >= compass_cnt || (a < accel_cnt && accel[a].timestamp <= compass_t[c])) {
+      batch[batch_cnt++] = accel[a++];
+      flush = batch_cnt == ACCEL_SAMPLES_PER_CALLBACK || a == accel_cnt;
+    } else {
+      now_ms = compass_t[c];
+      if (compass_on && laps_detect(compass[c], &turn_time)) {
+        lap_counted(turn_time, laps_t, confirm_t);
+      }
+      if (compass_on) {
+        recorder_compass(compass[c], compass_t[c]);
+      }
+      c++;
+    }
+
+    if (flush) {
+      now_ms = batch[batch_cnt - 1].timestamp;
+      int new_strokes = strokes_detect(batch, batch_cnt);
+      *strokes += new_strokes;
+      if (resumed_t != 0) {
+        strokes_after += new_strokes;
+      }
+      type_strokes[stroketype_current()] += new_strokes;
+      int32_t period = tempo_update(batch, batch_cnt);
+      if (period > 0) {
+        int rate = TEMPO_PER_MINUTE(period, STROKETYPE_PULLS(stroketype_current()));
+        tempo_strokes += rate * batch_cnt / (60.0 * ACCEL_SAMPLING_HZ);
+        tempo_rate_sum += rate;
+        tempo_rates++;
+      }
+      if (turns_detect(batch, batch_cnt, &push_time)) {
+        if (!compass_on) {
+          schedule_push_off();
+        }
+        if (laps_push_off(push_time, &turn_time)) {
+          lap_counted(turn_time, laps_t, confirm_t);
+        }
+      }
+      bool rested = rest_detect(batch, batch_cnt, &rest_time);
+      recorder_accel(batch, batch_cnt);
+      batch_cnt = 0;
+      if (rested) {
+        rests++;
+        resting = true;
+        if (compass_on) {
+          *compass_on_ms += now_ms - compass_on_since;
+        }
+        compass_on = false;
+        continue;
+      }
+
+      bool on = schedule_compass_on(now_ms - lap_start);
+      if (on && !compass_on) {
+        compass_on_since = now_ms;
+      } else if (!on && compass_on) {
+        *compass_on_ms += now_ms - compass_on_since;
+      }
+      compass_on = on;
+    }
+  }
+  if (compass_on) {
+    *compass_on_ms += now_ms - compass_on_since;
+  }
+
+  return laps;
+}
+
+// Match the detected laps to the real turns (nearest unmatched one) and report the timing error
+// and how long after the turn each lap was confirmed
+static void report_laps(uint64_t *laps_t, uint64_t *confirm_t, int laps) {
+  bool *matched = calloc(truth_laps + 1, sizeof(bool));
+  int hits = 0;
+  double err_sum = 0, err_max = 0;
+  double delay_sum = 0, delay_max = 0;
+
+  for (int i = 0; i < laps; i++) {
+    int best = -1;
+    int64_t best_err = 0;
+    for (int j = 0; j < truth_laps; j++) {
+      int64_t err = (int64_t)laps_t[i] - (int64_t)truth_laps_t[j];
+      if (!matched[j] && llabs(err) <= LAP_MATCH_MS && (best < 0 || llabs(err) < llabs(best_err))) {
+        best = j;
+        best_err = err;
+      }
+    }
+    if (best >= 0) {
+      matched[best] = true;
+      hits++;
+      err_sum += llabs(best_err) / 1000.0;
+      if (llabs(best_err) / 1000.0 > err_max) {
+        err_max = llabs(best_err) / 1000.0;
+      }
+      double delay = ((int64_t)confirm_t[i] - (int64_t)truth_laps_t[best]) / 1000.0;
+      delay_sum += delay;
+      if (delay > delay_max) {
+        delay_max = delay;
+      }
+    }
+  }
+
+  printf("laps:    detected %d, truth %d (matched %d, missed %d, false %d)\n",
+         laps, truth_laps, hits, truth_laps - hits, laps - hits);
+  if (hits > 0) {
+    printf("lap timing error: mean %.2f s, max %.2f s\n", err_sum / hits, err_max);
+    printf("lap confirmed after the wall: mean %.2f s, max %.2f s\n", delay_sum / hits, delay_max);
+  }
+  free(matched);
+}
+
+// Time the detectors on their own streams, repeating the trace until the run is long enough to measure
+static void report_throughput(int repeats) {
+  double duration = records_cnt ? (records[records_cnt - 1].t - records[0].t) / 1000.0 : 0;
+  double accel_s = 0, compass_s = 0;
+  int runs = 0;
+  volatile int sink = 0;
+  int64_t push_time;
+
+  do {
+    double t0 = seconds_now();
+    strokes_reset();
+    turns_reset();
+    tempo_reset();
+    for (int i = 0; i < accel_cnt; i += ACCEL_SAMPLES_PER_CALLBACK) {
+      int n = accel_cnt - i < ACCEL_SAMPLES_PER_CALLBACK ? accel_cnt - i : ACCEL_SAMPLES_PER_CALLBACK;
+      sink += strokes_detect(&accel[i], n);
+      sink += turns_detect(&accel[i], n, &push_time);
+      sink += tempo_update(&accel[i], n);
+    }
+    double t1 = seconds_now();
+    laps_reset();
+    for (int i = 0; i < compass_cnt; i++) {
+      int64_t turn_time;
+      now_ms = compass_t[i];
+      sink += laps_detect(compass[i], &turn_time);
+    }
+    double t2 = seconds_now();
+    accel_s += t1 - t0;
+    compass_s += t2 - t1;
+    runs++;
+  } while (runs < repeats || (repeats == 0 && accel_s + compass_s < 0.5));
+
+  if (accel_cnt > 0) {
+    printf("accel:   %.0f samples/s, %.1f ns/sample\n",
+           (double)accel_cnt * runs / accel_s, accel_s * 1e9 / ((double)accel_cnt * runs));
+  }
+  if (compass_cnt > 0) {
+    printf("compass: %.0f readings/s, %.1f ns/reading\n",
+           (double)compass_cnt * runs / compass_s, compass_s * 1e9 / ((double)compass_cnt * runs));
+  }
+  if (accel_s + compass_s > 0) {
+    printf("speed:   %.0fx real time (%d runs)\n", duration * runs / (accel_s + compass_s), runs);
+  }
+}
+
+int main(int argc, char **argv) {
+  int repeats = 0;
+  double max_stroke_error = -1;
+  int max_lap_error = -1;
+  const char *record_path = NULL;
+  bool check_rests = false;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:s:l:Rr:")) != -1) {
+    switch (opt) {
+      case 'n': repeats = atoi(optarg); break;
+      case 's': max_stroke_error = atof(optarg); break;
+      case 'l': max_lap_error = atoi(optarg); break;
+      case 'R': check_rests = true; break;
+      case 'r': record_path = optarg; break;
+      default:
+        fprintf(stderr, "usage: %s [-n repeats] [-s max_stroke_error_%%] [-l max_lap_error] [-R] [-r recording] trace.csv\n",
+                argv[0]);
+        return 2;
+    }
+  }
+  if (optind != argc - 1) {
+    fprintf(stderr, "usage: %s [-n repeats] [-s max_stroke_error_%%] [-l max_lap_error] [-R] [-r recording] trace.csv\n",
+            argv[0]);
+    return 2;
+  }
+
+  load_trace(argv[optind]);
+  printf("trace:   %s, %d accel samples, %d compass readings, %.1f s\n", argv[optind], accel_cnt, compass_cnt,
+         records_cnt ? (records[records_cnt - 1].t - records[0].t) / 1000.0 : 0);
+
+  int strokes;
+  uint64_t *laps_t = malloc((compass_cnt + accel_cnt + 1) * sizeof(uint64_t));
+  uint64_t *confirm_t = malloc((compass_cnt + accel_cnt + 1) * sizeof(uint64_t));
+  uint64_t compass_on_ms;
+  if (record_path) {
+    record_file = fopen(record_path, "wb");
+    if (!record_file) {
+      perror(record_path);
+      exit(2);
+    }
+    recorder_start();
+  }
+  replay_detect(&strokes, laps_t, confirm_t, &compass_on_ms);
+  if (record_file) {
+    recorder_stop();
+    fclose(record_file);
+    record_file = NULL;
+    printf("record:  %ld blocks of %d bytes, %.1f bytes/s\n", record_items, record_item_length,
+           records_cnt > 1 ? record_items * record_item_length * 1000.0 / (records[records_cnt - 1].t - records[0].t) : 0);
+  }
+
+  double stroke_error = truth_strokes ? 100.0 * abs(strokes - truth_strokes) / truth_strokes : 0;
+  printf("strokes: detected %d, truth %d (error %.1f%%)\n", strokes, truth_strokes, stroke_error);
+  printf("type:   ");
+  for (int i = STROKE_FREE; i < STROKE_TYPES; i++) {
+    printf(" %s %d%%", type_names[i], strokes ? 100 * type_strokes[i] / strokes : 0);
+  }
+  printf("\n");
+  printf("tempo:   mean %.1f strokes/min, %.0f strokes at that rate\n",
+         tempo_rates ? tempo_rate_sum / tempo_rates : 0, tempo_strokes);
+  report_laps(laps_t, confirm_t, laps);
+  printf("rests:   detected %d, truth %d\n", rests, truth_rests);
+
+  // The counts once the worker resumed after the first rest
+  int laps_after = 0, truth_laps_after = 0;
+  double stroke_error_after = 0;
+  if (truth_rests > 0) {
+    // The laps swum after the push-off, the one of the rest wall is before it
+    for (int i = 0; i < laps; i++) {
+      laps_after += resumed_t != 0 && laps_t[i] > resumed_t;
+    }
+    for (int i = 0; i < truth_laps; i++) {
+      truth_laps_after += truth_laps_t[i] > truth_rests_t[0];
+    }
+    stroke_error_after = truth_strokes_after ?
+                         100.0 * abs(strokes_after - truth_strokes_after) / truth_strokes_after : 0;
+    printf("resumed: %s, then strokes %d, truth %d (error %.1f%%), laps %d, truth %d\n",
+           resumed_t ? "on the push-off" : "never", strokes_after, truth_strokes_after, stroke_error_after,
+           laps_after, truth_laps_after);
+  }
+  if (records_cnt > 1) {
+    printf("compass: on %.0f%% of the time\n", 100.0 * compass_on_ms / (records[records_cnt - 1].t - records[0].t));
+  }
+  report_throughput(repeats);
+
+  int status = 0;
+  if (max_stroke_error >= 0 && stroke_error > max_stroke_error) {
+    printf("FAIL: stroke error %.1f%% > %.1f%%\n", stroke_error, max_stroke_error);
+    status = 1;
+  }
+  if (max_lap_error >= 0 && abs(laps - truth_laps) > max_lap_error) {
+    printf("FAIL: lap error %d > %d\n", abs(laps - truth_laps), max_lap_error);
+    status = 1;
+  }
+
+  if (check_rests && rests != truth_rests) {
+    printf("FAIL: %d rests detected, %d real ones\n", rests, truth_rests);
+    status = 1;
+  }
+  if (check_rests && truth_rests > 0 &&
+      (resumed_t == 0 || (max_stroke_error >= 0 && stroke_error_after > max_stroke_error) ||
+       (max_lap_error >= 0 && abs(laps_after - truth_laps_after) > max_lap_error))) {
+    printf("FAIL: the counts did not resume after the rest\n");
+    status = 1;
+  }
+
+  free(laps_t);
+  free(confirm_t);
+  return status;
+}
\ No newline at end of file
@@ -0,0 +1,244 @@
+// Synthetic swim trace generator
+//
+// Writes a deterministic trace in the replay format (see replay.c) with its ground truth:
+// a push-off from the wall, a number of pool lengths of one stroke type with a wall turn between
+// them, and a rest at the wall at the end. With -w the swimmer also rests at the wall halfway,
+// standing still (the wall turn is then done during the rest), before pushing off again.
+//
+// The watch is on the wrist: x along the forearm, y across it, z out of the face. Freestyle and
+// backstroke turn gravity around the wrist in opposite directions, butterfly also does it with a
+// wide sweep of both arms at once, and breaststroke keeps the hands in front, face down.
+// The ground truth counts a stroke per arm pull: two per cycle of the alternating strokes, one
+// per cycle of the simultaneous ones.
+//
+// Usage: synth [-n lengths] [-d length_s] [-c stroke_cycle_s] [-a heading] [-s free|back|breast|fly]
+//              [-f accel_hz] [-w wall_rest_s] [-r seed] > trace.csv
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define COMPASS_HZ 4
+#define COMPASS_FILTER 5 // degrees, like compass_service_set_heading_filter() in the worker
+#define TURN_S 1.5       // flip turn at the wall
+#define GLIDE_S 2.0      // push-off and glide after the wall
+#define WALL_NOISE 8     // mg, of the still wrist while resting at the wall
+
+static int accel_hz = 25;   // the watch samples at 25Hz, 50Hz on basalt
+static uint32_t seed = 1;
+
+static double uniform() {
+  // xorshift32
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed / 4294967296.0;
+}
+
+static double noise(double sd) {
+  // Irwin-Hall approximation of a normal distribution
+  double s = 0;
+  for (int i = 0; i < 12; i++) {
+    s += uniform();
+  }
+  return (s - 6) * sd;
+}
+
+enum { REST, GLIDE, SWIM, TURN, WALL };
+
+enum { FREE, BACK, BREAST, FLY };
+static const char *style_names[] = { "free", "back", "breast", "fly" };
+
+static void emit_accel(int ms, int phase, double phase_t, double cycle, int style) {
+  double x, y, z;
+  double sd = phase == WALL ? WALL_NOISE : 25;
+
+  switch (phase) {
+    case SWIM: {
+      // Arm rotation turns gravity around the wrist, the pull adds a linear acceleration pulse
+      double a = 2 * M_PI * phase_t / cycle;
+      double pull = sin(a) > 0 ? 900 * pow(sin(a), 2) : 0;
+      switch (style) {
+        case BACK:
+          x = 1000 * cos(a) + pull;
+          y = 150 * sin(2 * a);
+          z = -1000 * sin(a);
+          break;
+        case BREAST:
+          // Out-sweep and in-sweep of the hands, then the shoot forward
+          x = 350 * sin(a) + 0.5 * pull;
+          y = 600 * sin(a + M_PI / 3);
+          z = -900 + 150 * cos(a);
+          break;
+        case FLY:
+          x = 1000 * cos(a) + 1.3 * pull;
+          y = 550 * sin(a - M_PI / 4);
+          z = 1000 * sin(a);
+          break;
+        default:
+          x = 1000 * cos(a) + pull;
+          y = 150 * sin(2 * a);
+          z = 1000 * sin(a);
+          break;
+      }
+      break;
+    }
+    case TURN:
+      // Tumble
+      x = 1400 * sin(7 * phase_t) + noise(200);
+      y = 1200 * cos(5 * phase_t) + noise(200);
+      z = 800 * sin(3 * phase_t) + noise(200);
+      break;
+    case GLIDE:
+      // Push-off spike then a smooth deceleration with the arms stretched forward
+      if (phase_t < 0.3) {
+        x = 2500;
+      } else {
+        x = -350 * exp(-(phase_t - 0.3));
+      }
+      y = 0;
+      z = 1000;
+      break;
+    default:
+      x = 0;
+      y = 0;
+      z = -1000;
+      break;
+  }
+
+  printf("a,%d,%d,%d,%d\n", ms, (int)(x + noise(sd)), (int)(y + noise(sd)), (int)(z + noise(sd)));
+}
+
+int main(int argc, char **argv) {
+  int lengths = 8;
+  double length_s = 30;
+  double cycle = 1.4;
+  int heading0 = 90;
+  int style = FREE;
+  double wall_rest_s = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:d:c:a:s:f:w:r:")) != -1) {
+    switch (opt) {
+      case 'n': lengths = atoi(optarg); break;
+      case 'd': length_s = atof(optarg); break;
+      case 'c': cycle = atof(optarg); break;
+      case 'a': heading0 = atoi(optarg); break;
+      case 's':
+        for (style = FREE; style <= FLY && strcmp(optarg, style_names[style]) != 0; style++) {
+        }
+        if (style > FLY) {
+          fprintf(stderr, "unknown stroke type %s\n", optarg);
+          return 2;
+        }
+        break;
+      case 'f': accel_hz = atoi(optarg); break;
+      case 'w': wall_rest_s = atof(optarg); break;
+      case 'r': seed = (uint32_t)atoi(optarg) | 1; break;
+      default:
+        fprintf(stderr, "usage: %s [-n lengths] [-d length_s] [-c stroke_cycle_s] [-a heading] "
+                "[-s free|back|breast|fly] [-f accel_hz] [-w wall_rest_s] [-r seed]\n", argv[0]);
+        return 2;
+    }
+  }
+  int pulls = style == BREAST || style == FLY ? 1 : 2; // arm strokes per cycle
+
+  printf("# synth -n %d -d %g -c %g -a %d -s %s -f %d -w %g\n", lengths, length_s, cycle, heading0,
+         style_names[style], accel_hz, wall_rest_s);
+
+  // Time line of the workout, one segment per phase: each length starts with the push-off and ends
+  // with the wall turn, or the rest at the wall after the length rest_after
+  double rest_s = 3;
+  int rest_after = wall_rest_s > 0 ? lengths / 2 - 1 : -1;
+  double *starts = malloc((lengths + 1) * sizeof(double));
+  starts[0] = 0;
+  for (int i = 0; i < lengths; i++) {
+    starts[i + 1] = starts[i] + GLIDE_S + length_s + (i == rest_after ? wall_rest_s : TURN_S);
+  }
+  double total = rest_s + starts[lengths] - TURN_S + rest_s;
+  int total_ms = (int)(total * 1000);
+  int last_heading = -1000;
+  int next_stroke_ms = 0;
+  int prev_phase = REST;
+
+  for (int ms = 0; ms <= total_ms; ms += 1000 / accel_hz) {
+    double t = ms / 1000.0;
+    double seg = t - rest_s;
+    double heading_base = 0;
+    int phase = REST;
+    double phase_t = t;
+    int length = 0;
+
+    if (seg >= 0) {
+      while (length < lengths && seg >= starts[length + 1]) {
+        length++;
+      }
+      double in = seg - starts[length];
+      if (length >= lengths) {
+        length = lengths - 1;
+        phase = REST;
+        phase_t = in;
+      } else if (in < GLIDE_S) {
+        phase = GLIDE;
+        phase_t = in;
+      } else if (in < GLIDE_S + length_s) {
+        phase = SWIM;
+        phase_t = in - GLIDE_S;
+      } else if (length == rest_after) {
+        phase = WALL;
+        phase_t = in - GLIDE_S - length_s;
+      } else if (length < lengths - 1) {
+        phase = TURN;
+        phase_t = in - GLIDE_S - length_s;
+      } else {
+        phase = REST;
+        phase_t = in - GLIDE_S - length_s;
+      }
+    }
+
+    heading_base = heading0 + 180 * (length % 2);
+    if (phase == TURN || phase == WALL) {
+      heading_base += 180 * fmin(phase_t / TURN_S, 1); // turning around, then standing still
+    }
+
+    // Ground truth
+    if (phase == SWIM) {
+      int swim_start_ms = ms - (int)(phase_t * 1000);
+      if (next_stroke_ms < swim_start_ms) {
+        next_stroke_ms = swim_start_ms + (int)(cycle * 1000 / (2 * pulls));
+      }
+      if (ms >= next_stroke_ms) {
+        printf("S,%d\n", ms);
+        next_stroke_ms += (int)(cycle * 1000 / pulls);
+      }
+    } else if ((phase == TURN || phase == WALL) && prev_phase != phase) {
+      printf("L,%d\n", ms); // touching the wall
+      if (phase == WALL) {
+        printf("R,%d\n", ms);
+      }
+    }
+    prev_phase = phase;
+
+    emit_accel(ms, phase, phase_t, cycle, style);
+
+    // Compass, with noise and the body roll of the strokes, filtered like the watch does
+    if (ms % (1000 / COMPASS_HZ) < 1000 / accel_hz) {
+      double wobble = phase == SWIM ? 25 * sin(2 * M_PI * phase_t / cycle) : 0;
+      int heading = ((int)lround(heading_base + wobble + noise(4)) % 360 + 360) % 360;
+      int diff = abs(heading - last_heading) % 360;
+      if (diff > 180) {
+        diff = 360 - diff;
+      }
+      if (diff >= COMPASS_FILTER) {
+        printf("c,%d,%d\n", ms, heading);
+        last_heading = heading;
+      }
+    }
+  }
+
+  free(starts);
+  return 0;
+}
\ No newline at end of file
@@ -1,63 +1,60 @@
 // common functions
 
+#ifdef UBISWIM_WORKER
+#include <pebble_worker.h> // also built into the background worker, see wscript
+#else
 #include <pebble.h>
-
-// update the epapsed time string
-void update_elapsed_time(double elapsed_time, char* elapsed_time_str) {
-  int hundredths = (int)(elapsed_time * 100) % 100;
-  int seconds = (int)elapsed_time % 60;
-  int minutes = (int)elapsed_time / 60 % 60;
-  int hours = (int)elapsed_time / 3600;
-
-  snprintf(elapsed_time_str, 12, "%02d:%02d:%02d.%02d", hours, minutes, seconds, hundredths);
+#endif
+
+// update the epapsed time string (HH:MM:SS.hh, or HH:MM:SS without the hundredths), in a buffer of
+// 12 chars at least. The hours stop at 99, they fill the 2 digits.
+void update_elapsed_time(uint32_t elapsed_ms, char* elapsed_time_str, bool hundredths_on) {
+  uint32_t elapsed_s = elapsed_ms / 1000;
+  int hundredths = elapsed_ms % 1000 / 10;
+  int seconds = elapsed_s % 60;
+  int minutes = elapsed_s / 60 % 60;
+  int hours = elapsed_s / 3600 < 99 ? elapsed_s / 3600 : 99;
+
+  if (hundredths_on) {
+    snprintf(elapsed_time_str, 12, "%02d:%02d:%02d.%02d", hours, minutes, seconds, hundredths);
+  } else {
+    snprintf(elapsed_time_str, 12, "%02d:%02d:%02d", hours, minutes, seconds);
+  }
 }
 
-// Create a current date & time string
+// Create a current date & time string (YYYY-MM-DD HH:MM:SS), in a buffer of 20 chars at least
 void createDateTimeStr(char *date_time_str) {
-  // Clear the date_time_str char array parameter, in case it isn't already empty!
-  // If you don't clear the arr and it's not empty, the new date & time string will be concatenated right
-  // after the old one, resulting in a 39 characters string.
-  memset(date_time_str, 0, sizeof(date_time_str));
-  //
-  // Get a tm structure
-  time_t temp = time(NULL); 
+  time_t temp = time(NULL);
   struct tm *tick_time = localtime(&temp);
-  //
-  // Get date
-  static char date_buffer[12];
-  strftime(date_buffer, sizeof(date_buffer), "%Y-%m-%d ", tick_time);
-  //
-  // Get time
-  static char time_buffer[9];
-  strftime(time_buffer, sizeof(time_buffer), clock_is_24h_style() ? "%H:%M:%S" : "%I:%M%S", tick_time);
-  //
-  // Concat date & time
-  static char date_time_buffer[20];
-  strncat(date_time_buffer, date_buffer, 11);
-  strncat(date_time_buffer, time_buffer, 8);
-  //
-  // Return the newly created date & time string by reference
-  strcat(date_time_str, date_time_buffer);
+
+  strftime(date_time_str, 20, clock_is_24h_style() ? "%Y-%m-%d %H:%M:%S" : "%Y-%m-%d %I:%M:%S", tick_time);
 }
 
-// return current time
-double float_time_ms() {
-	time_t seconds;
-	uint16_t milliseconds;
-	time_ms(&seconds, &milliseconds);
+// return current time in ms, the timebase of the accelerometer timestamps
+int64_t clock_ms() {
+  time_t seconds;
+  uint16_t milliseconds;
+  time_ms(&seconds, &milliseconds);
 
-	return (double)seconds + ((double)milliseconds / 1000.0);
+  return (int64_t)seconds * 1000 + milliseconds;
 }
 
-// return the square root of a float
-float mySqrtf(const float x) {
-  const float xhalf = 0.5f*x;
-  union {
-    float x;
-    int i;
-  } u;
-  u.x = x;
-  u.i = 0x5f3759df - (u.i >> 1);
-
-  return x*u.x*(1.5f - xhalf*u.x*u.x) + 1;
+// Integer square root (rounded down), bit by bit
+uint32_t isqrt(uint32_t value) {
+  uint32_t root = 0;
+  uint32_t bit = 1u << 30;
+
+  while (bit > value) {
+    bit >>= 2;
+  }
+  while (bit != 0) {
+    if (value >= root + bit) {
+      value -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return root;
 }
\ No newline at end of file
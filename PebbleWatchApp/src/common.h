@@ -1,6 +1,6 @@
 // common functions prototypes
 
-void update_elapsed_time(double elapsed_time, char* elapsed_time_str);
+void update_elapsed_time(uint32_t elapsed_ms, char* elapsed_time_str, bool hundredths_on);
 void createDateTimeStr(char* date_time_str);
-double float_time_ms();
-float mySqrtf(const float x);
\ No newline at end of file
+int64_t clock_ms();
+uint32_t isqrt(uint32_t value);
\ No newline at end of file
@@ -0,0 +1,77 @@
+// social feed code
+//
+// The messages received from friends, in a ring buffer of fixed size records: no heap is used on
+// receive and the social screen reads the records in place.
+
+#include <pebble.h>
+#include <feed.h>
+#include <store.h>
+
+// Persistent memory layout, kept in the blob store
+#define FEED_VERSION 1
+
+typedef struct {
+  uint8_t head;
+  uint8_t count;
+} __attribute__((__packed__)) FeedHeader;
+
+// Ring buffer of messages, saved as is: a new message only changes the chunks of its slot
+static struct {
+  FeedHeader header;
+  FeedMessage messages[FEED_CAPACITY];
+} s_feed;
+static FeedMessage *s_messages = s_feed.messages;
+static int s_head = 0;         // next slot to write
+static int s_count = 0;
+
+// Drop all the messages (new workout)
+void feed_reset() {
+  s_head = 0;
+  s_count = 0;
+}
+
+// Append a message, replacing the oldest one when the feed is full. O(1)
+// Longer sender names and texts are truncated.
+void feed_add(const char *sender, const char *text, time_t time) {
+  FeedMessage *message = &s_messages[s_head];
+
+  snprintf(message->sender, sizeof(message->sender), "%s", sender);
+  snprintf(message->text, sizeof(message->text), "%s", text);
+  message->time = time;
+
+  s_head = (s_head + 1) % FEED_CAPACITY;
+  if (s_count < FEED_CAPACITY) {
+    s_count++;
+  }
+}
+
+int feed_count() {
+  return s_count;
+}
+
+// Get a message, index 0 is the oldest one and feed_count() - 1 the newest
+const FeedMessage *feed_get(int index) {
+  return &s_messages[(s_head - s_count + index + FEED_CAPACITY) % FEED_CAPACITY];
+}
+
+// Write the messages to persistent memory, only the changed chunks are written
+void feed_save(uint32_t key) {
+  s_feed.header.head = s_head;
+  s_feed.header.count = s_count;
+  store_write(key, FEED_VERSION, &s_feed, sizeof(s_feed));
+}
+
+// Read the messages from persistent memory
+void feed_load(uint32_t key) {
+  feed_reset();
+
+  if (store_length(key, FEED_VERSION) != sizeof(s_feed) ||
+      !store_read(key, FEED_VERSION, &s_feed, 0, sizeof(s_feed)) ||
+      s_feed.header.head >= FEED_CAPACITY || s_feed.header.count > FEED_CAPACITY) {
+    memset(&s_feed, 0, sizeof(s_feed)); // missing or incomplete, start over
+    return;
+  }
+
+  s_head = s_feed.header.head;
+  s_count = s_feed.header.count;
+}
\ No newline at end of file
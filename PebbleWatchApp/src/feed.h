@@ -0,0 +1,20 @@
+// social feed functions prototypes
+
+// Social feed sizes
+#define FEED_CAPACITY 16    // messages kept, a new one replaces the oldest
+#define FEED_SENDER_LEN 16  // including the terminating 0
+#define FEED_TEXT_LEN 48    // including the terminating 0
+
+// A message received from a friend
+typedef struct {
+  char sender[FEED_SENDER_LEN];
+  char text[FEED_TEXT_LEN];
+  time_t time;
+} FeedMessage;
+
+void feed_reset();
+void feed_add(const char *sender, const char *text, time_t time);
+int feed_count();
+const FeedMessage *feed_get(int index);
+void feed_save(uint32_t key);
+void feed_load(uint32_t key);
\ No newline at end of file
@@ -0,0 +1,184 @@
+// workout history code
+//
+// Summaries of the last workouts, in a ring buffer of fixed size records kept in date order: the
+// ring is its own date index (see history_find()). Each rolling baseline keeps the running sums of
+// the workouts of its period, a workout is added to them when it ends and subtracted when it gets
+// older than the period or leaves the ring. The SSI of a lap then reads a mean of the sums instead
+// of scanning the records.
+
+#include <pebble.h>
+#include <history.h>
+#include <store.h>
+
+// Persistent memory layout, kept in the blob store
+#define HISTORY_VERSION 1
+
+// Running sums of the workouts of a period, the ones from the sequence number tail on
+typedef struct {
+  uint16_t tail;
+  uint32_t swolf_sum;
+  uint32_t pace_sum;
+  uint16_t pace_count;  // workouts with a pace
+} __attribute__((__packed__)) HistoryWindow;
+
+typedef struct {
+  uint16_t total;       // sequence number of the next workout, wraps around
+  uint8_t count;
+  HistoryWindow windows[HISTORY_PERIODS];
+} __attribute__((__packed__)) HistoryHeader;
+
+// Ring buffer of workouts, saved as is: a new workout only changes the chunks of the header and
+// of its slot
+static struct {
+  HistoryHeader header;
+  HistoryRecord records[HISTORY_CAPACITY];
+} s_history;
+static HistoryHeader *s_header = &s_history.header;
+static uint32_t s_key;
+
+static const uint32_t s_periods_s[HISTORY_PERIODS] = { 7 * HISTORY_DAY_S, 30 * HISTORY_DAY_S };
+
+// Slot of a sequence number, they wrap around at 65536, a multiple of HISTORY_CAPACITY
+static HistoryRecord *record_at(uint16_t sequence) {
+  return &s_history.records[sequence % HISTORY_CAPACITY];
+}
+
+static int window_count(const HistoryWindow *window) {
+  return (uint16_t)(s_header->total - window->tail);
+}
+
+// Subtract the oldest workout of a window
+static void window_pop(HistoryWindow *window) {
+  const HistoryRecord *record = record_at(window->tail);
+
+  window->swolf_sum -= record->swolf_avg;
+  if (record->pace_avg > 0) {
+    window->pace_sum -= record->pace_avg;
+    window->pace_count--;
+  }
+  window->tail++;
+}
+
+// Write the history to persistent memory, only the changed chunks are written
+static void save() {
+  store_write(s_key, HISTORY_VERSION, &s_history, sizeof(s_history));
+}
+
+// Drop all the workouts (reset by the swimmer)
+void history_reset() {
+  memset(&s_history, 0, sizeof(s_history));
+  save();
+}
+
+// Append a finished workout, replacing the oldest one when the history is full. O(1)
+void history_add(const HistoryRecord *record) {
+  HistoryRecord *slot = record_at(s_header->total);
+  uint32_t newest = s_header->count > 0 ? history_get(s_header->count - 1)->date : 0;
+
+  if (s_header->count == HISTORY_CAPACITY) {
+    // The oldest workout leaves the ring, and the windows still holding it
+    for (int i = 0; i < HISTORY_PERIODS; i++) {
+      if (window_count(&s_header->windows[i]) == HISTORY_CAPACITY) {
+        window_pop(&s_header->windows[i]);
+      }
+    }
+  } else {
+    s_header->count++;
+  }
+
+  *slot = *record;
+  if (slot->date < newest) {
+    slot->date = newest; // the clock went back, keep the date order
+  }
+  s_header->total++;
+
+  for (int i = 0; i < HISTORY_PERIODS; i++) {
+    HistoryWindow *window = &s_header->windows[i];
+    window->swolf_sum += slot->swolf_avg;
+    if (slot->pace_avg > 0) {
+      window->pace_sum += slot->pace_avg;
+      window->pace_count++;
+    }
+  }
+  save();
+}
+
+// Subtract the workouts older than its period from each window. The windows only move forward,
+// each workout is subtracted once.
+void history_update(time_t now) {
+  uint16_t oldest = s_header->total - s_header->count;
+
+  for (int i = 0; i < HISTORY_PERIODS; i++) {
+    HistoryWindow *window = &s_header->windows[i];
+    uint16_t first = oldest + history_find(now - (time_t)s_periods_s[i]);
+    while ((int16_t)(first - window->tail) > 0) {
+      window_pop(window);
+    }
+  }
+}
+
+int history_count() {
+  return s_header->count;
+}
+
+// Get a workout, index 0 is the oldest one and history_count() - 1 the newest
+const HistoryRecord *history_get(int index) {
+  return record_at(s_header->total - s_header->count + index);
+}
+
+// Index of the first workout that ended at or after a date, history_count() when none did.
+// O(log n), the records are in date order.
+int history_find(time_t since) {
+  int low = 0;
+  int high = s_header->count;
+
+  while (low < high) {
+    int middle = (low + high) / 2;
+    if ((time_t)history_get(middle)->date < since) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+// Workouts of a period, as of the last history_update()
+int history_workouts(HistoryPeriod period) {
+  return window_count(&s_header->windows[period]);
+}
+
+// SWOLF average of the workouts of a period (rounded), 0 when there is none
+int history_swolf_avg(HistoryPeriod period) {
+  const HistoryWindow *window = &s_header->windows[period];
+  int count = window_count(window);
+
+  return count > 0 ? (int)((window->swolf_sum + count / 2) / count) : 0;
+}
+
+// Pace average of the workouts of a period (rounded), 0 when there is none
+int history_pace_avg(HistoryPeriod period) {
+  const HistoryWindow *window = &s_header->windows[period];
+
+  return window->pace_count > 0 ?
+         (int)((window->pace_sum + window->pace_count / 2) / window->pace_count) : 0;
+}
+
+// Read the history from persistent memory
+void history_load(uint32_t key) {
+  s_key = key;
+
+  if (store_length(key, HISTORY_VERSION) != sizeof(s_history) ||
+      !store_read(key, HISTORY_VERSION, &s_history, 0, sizeof(s_history)) ||
+      s_header->count > HISTORY_CAPACITY) {
+    memset(&s_history, 0, sizeof(s_history)); // missing or incomplete, start over
+    return;
+  }
+  for (int i = 0; i < HISTORY_PERIODS; i++) {
+    const HistoryWindow *window = &s_header->windows[i];
+    if (window_count(window) > s_header->count || window->pace_count > window_count(window)) {
+      memset(&s_history, 0, sizeof(s_history));
+      return;
+    }
+  }
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+// workout history functions prototypes
+
+// History sizes
+#define HISTORY_CAPACITY 32  // workouts kept, a new one replaces the oldest
+#define HISTORY_DAY_S (24 * 60 * 60)
+
+// Summary of a finished workout, 16 bytes
+typedef struct {
+  uint32_t date;        // time() at the end of the workout
+  uint32_t elapsed_ms;
+  uint16_t laps;
+  uint16_t distance;    // m
+  uint16_t swolf_avg;   // on a 25m basis
+  uint16_t pace_avg;    // tenths of a second per 100m, 0 when unknown
+} __attribute__((__packed__)) HistoryRecord;
+
+// Rolling baselines, over the workouts of the last days
+typedef enum {
+  HISTORY_WEEK,   // 7 days
+  HISTORY_MONTH,  // 30 days, HISTORY_CAPACITY workouts at most
+  HISTORY_PERIODS
+} HistoryPeriod;
+
+void history_load(uint32_t key);
+void history_reset();
+void history_add(const HistoryRecord *record);
+void history_update(time_t now);
+int history_count();
+const HistoryRecord *history_get(int index);
+int history_find(time_t since);
+int history_workouts(HistoryPeriod period);
+int history_swolf_avg(HistoryPeriod period);
+int history_pace_avg(HistoryPeriod period);
\ No newline at end of file
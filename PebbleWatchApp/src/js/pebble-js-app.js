@@ -0,0 +1,103 @@
+// UbiSwim phone side decoder of the workout updates (see protocol.c on the watch)
+
+var PROTOCOL_VERSION = 3;
+var PROTOCOL_NO_BASE = 0xff;
+var FIELDS = ['elapsedMs', 'strokes', 'laps', 'distance', 'pool', 'swolfAvg', 'ssi', 'likes',
+              'swolfSd', 'swolfBest', 'paceAvg', 'paceBest', 'strokesAvg', 'bestLap'];
+var STROKE_TYPES = ['unknown', 'free', 'back', 'breast', 'fly']; // StrokeType, see sensing.h
+
+// States of the last sequences, a payload is a delta against one of them
+var states = {};
+
+function readVarint(bytes, pos) {
+  var value = 0;
+  var shift = 0;
+  var b;
+  do {
+    b = bytes[pos.i++];
+    value += (b & 0x7f) * Math.pow(2, shift);
+    shift += 7;
+  } while (b & 0x80);
+  return value;
+}
+
+function unzigzag(value) {
+  return value % 2 ? -(value + 1) / 2 : value / 2;
+}
+
+// Decode an update payload (array of bytes), returns the workout state with its new laps,
+// or null when the payload cannot be applied
+function decodeUpdate(bytes) {
+  var pos = { i: 0 };
+  if (bytes[pos.i++] !== PROTOCOL_VERSION) {
+    return null;
+  }
+  var sequence = bytes[pos.i++];
+  var baseSequence = bytes[pos.i++];
+  var mask = bytes[pos.i++];
+  mask |= bytes[pos.i++] << 8;
+
+  var base = baseSequence === PROTOCOL_NO_BASE ? null : states[baseSequence];
+  if (baseSequence !== PROTOCOL_NO_BASE && !base) {
+    return null;
+  }
+
+  var state = {};
+  for (var f = 0; f < FIELDS.length; f++) {
+    state[FIELDS[f]] = base ? base[FIELDS[f]] : 0;
+    if (mask & (1 << f)) {
+      state[FIELDS[f]] += unzigzag(readVarint(bytes, pos));
+    }
+  }
+
+  var count = bytes[pos.i++];
+  var laps = [];
+  var previous = { index: 0, startMs: 0 };
+  for (var l = 0; l < count; l++) {
+    var lap = {};
+    lap.index = previous.index + readVarint(bytes, pos);
+    lap.startMs = previous.startMs + readVarint(bytes, pos);
+    lap.durationMs = readVarint(bytes, pos);
+    lap.strokes = readVarint(bytes, pos);
+    lap.swolf = readVarint(bytes, pos);
+    lap.strokeType = STROKE_TYPES[readVarint(bytes, pos)] || 'unknown';
+    laps.push(lap);
+    previous = lap;
+  }
+
+  // Keep the states the watch may still use as base, it only goes forward
+  states[sequence] = state;
+  delete states[(sequence + 128) % PROTOCOL_NO_BASE];
+
+  return { sequence: sequence, state: state, laps: laps };
+}
+
+// Ask the watch for its full state, the states the deltas are against are gone
+function resync() {
+  Pebble.sendAppMessage({ resync: 1 });
+}
+
+Pebble.addEventListener('ready', function() {
+  resync();
+});
+
+Pebble.addEventListener('appmessage', function(e) {
+  var payload = e.payload;
+  var update = payload.update || payload['10'];
+  if (!update) {
+    return;
+  }
+  var decoded = decodeUpdate(update);
+  if (!decoded) {
+    console.log('UbiSwim: update without its base state');
+    resync();
+    return;
+  }
+  decoded.workoutId = payload.workoutId || payload['0'];
+  // The newest friend messages since the last ack, one per line, the likes delta counts them all
+  var social = payload.social || payload['5'];
+  decoded.social = social ? social.split('\n') : [];
+  // The companion app reads the totals from keys 0 to 9 of the same message, the laps are only
+  // decoded here for now
+  console.log('UbiSwim: ' + JSON.stringify(decoded));
+});
\ No newline at end of file
@@ -0,0 +1,54 @@
+// lap log code
+//
+// The splits of the workout, in a preallocated ring buffer of packed records: appending a lap
+// costs the same at any lap and uses no heap.
+
+#include <pebble.h>
+#include <laplog.h>
+
+// Ring buffer of laps
+static LapRecord s_laps[LAPLOG_CAPACITY];
+static int s_head = 0;  // next slot to write
+static int s_count = 0;
+
+// Clamp a counter into a byte
+static uint8_t clamp_u8(int value) {
+  return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+// Drop all the laps (new workout)
+void laplog_reset() {
+  s_head = 0;
+  s_count = 0;
+}
+
+// Append a lap, replacing the oldest one when the log is full. O(1)
+void laplog_add(int index, uint32_t start_ms, uint32_t duration_ms, int strokes, int swolf, int stroke_type) {
+  LapRecord *record = &s_laps[s_head];
+
+  record->index = index;
+  record->start_ms = start_ms;
+  record->duration_ms = duration_ms;
+  record->strokes = clamp_u8(strokes);
+  record->swolf = clamp_u8(swolf);
+  record->stroke_type = stroke_type;
+
+  s_head = (s_head + 1) % LAPLOG_CAPACITY;
+  if (s_count < LAPLOG_CAPACITY) {
+    s_count++;
+  }
+}
+
+int laplog_count() {
+  return s_count;
+}
+
+// Get a lap, index 0 is the oldest one kept and laplog_count() - 1 the newest
+const LapRecord *laplog_get(int index) {
+  return &s_laps[(s_head - s_count + index + LAPLOG_CAPACITY) % LAPLOG_CAPACITY];
+}
+
+// The newest lap, or NULL before the first lap
+const LapRecord *laplog_last() {
+  return s_count > 0 ? laplog_get(s_count - 1) : NULL;
+}
\ No newline at end of file
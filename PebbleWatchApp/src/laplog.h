@@ -0,0 +1,20 @@
+// lap log functions prototypes
+
+// Laps kept, a new one replaces the oldest (3.2km in a 25m pool)
+#define LAPLOG_CAPACITY 128
+
+// A lap split, 13 bytes
+typedef struct {
+  uint16_t index;        // lap number, from 1
+  uint32_t start_ms;     // workout time at the start of the lap
+  uint32_t duration_ms;
+  uint8_t strokes;
+  uint8_t swolf;
+  uint8_t stroke_type;   // StrokeType, see sensing.h
+} __attribute__((__packed__)) LapRecord;
+
+void laplog_reset();
+void laplog_add(int index, uint32_t start_ms, uint32_t duration_ms, int strokes, int swolf, int stroke_type);
+int laplog_count();
+const LapRecord *laplog_get(int index);
+const LapRecord *laplog_last();
\ No newline at end of file
@@ -0,0 +1,108 @@
+// metrics layer code
+//
+// A single custom drawn layer showing all the counters of the main screen, instead of a TextLayer
+// (and a string buffer) each. Every region keeps its formatted text and is only re-formatted when
+// it has been marked dirty, the others are just drawn again from the cache. The drawing itself is
+// not partial: the system renders the whole window whenever a layer of it is dirty, so child layers
+// per region would cost the same.
+
+#include <pebble.h>
+#include <common.h>
+#include <metrics.h>
+
+// Metrics to draw, owned by the caller
+static Metrics *s_metrics;
+
+// Regions to re-format on the next redraw
+static uint8_t s_dirty = METRIC_ALL;
+
+// Cached fonts
+static GFont s_font_14;
+static GFont s_font_28_bold;
+static GFont s_font_18_bold;
+static GFont s_font_42_bold;
+
+// Cached texts
+static char s_time[12];
+static char s_strokes[16];
+static char s_rate[16];
+static char s_laps[10];
+static char s_distance[10];
+static char s_swolf_avg[12];
+
+// Re-format the texts of the dirty regions
+static void format_dirty() {
+  if (s_dirty & METRIC_TIME) {
+    update_elapsed_time(s_metrics->elapsed_ms, s_time, s_metrics->hundredths);
+  }
+  if (s_dirty & METRIC_STROKES) {
+    snprintf(s_strokes, sizeof(s_strokes), "strokes:%d", s_metrics->strokes);
+  }
+  if (s_dirty & METRIC_RATE) {
+    if (s_metrics->stroke_rate > 0) {
+      snprintf(s_rate, sizeof(s_rate), "rate:%d/min", s_metrics->stroke_rate);
+    } else {
+      snprintf(s_rate, sizeof(s_rate), "rate:--");
+    }
+  }
+  if (s_dirty & METRIC_LAPS) {
+    snprintf(s_laps, sizeof(s_laps), "laps:%d", s_metrics->laps);
+  }
+  if (s_dirty & METRIC_DISTANCE) {
+    snprintf(s_distance, sizeof(s_distance), "%d", s_metrics->distance);
+  }
+  if (s_dirty & METRIC_SWOLF) {
+    snprintf(s_swolf_avg, sizeof(s_swolf_avg), "SWOLF: %d", s_metrics->swolf_avg);
+  }
+  s_dirty = 0;
+}
+
+static void draw_text(GContext *ctx, const char *text, GFont font, GRect rect, GTextAlignment alignment) {
+  graphics_draw_text(ctx, text, font, rect, GTextOverflowModeTrailingEllipsis, alignment, NULL);
+}
+
+// Draw all the metrics
+static void update_proc(Layer *layer, GContext *ctx) {
+  GRect bounds = layer_get_bounds(layer);
+  int16_t w = bounds.size.w;
+
+  format_dirty();
+
+  graphics_context_set_text_color(ctx, GColorBlack);
+  draw_text(ctx, "UbiSwim.org", s_font_14, GRect(0, 0, w, 16), GTextAlignmentCenter);
+  draw_text(ctx, s_time, s_font_28_bold, GRect(0, 20, w, 28), GTextAlignmentCenter);
+  draw_text(ctx, s_distance, s_font_42_bold, GRect(0, 50, 120, 42), GTextAlignmentRight);
+  draw_text(ctx, "m", s_font_18_bold, GRect(120, 70, w - 120, 18), GTextAlignmentLeft);
+  draw_text(ctx, s_swolf_avg, s_font_28_bold, GRect(0, 92, 120, 28), GTextAlignmentRight);
+  draw_text(ctx, s_rate, s_font_14, GRect(8, 120, w - 16, 15), GTextAlignmentLeft);
+  draw_text(ctx, s_strokes, s_font_14, GRect(8, 135, 90, 16), GTextAlignmentLeft);
+  draw_text(ctx, s_laps, s_font_14, GRect(90, 135, 50, 16), GTextAlignmentLeft);
+  draw_text(ctx, s_metrics->msg, s_font_14, GRect(0, 150, w, 16), GTextAlignmentCenter);
+}
+
+// Create the metrics layer, drawing the values of metrics
+Layer *metrics_layer_create(GRect bounds, Metrics *metrics) {
+  s_metrics = metrics;
+  s_dirty = METRIC_ALL;
+
+  s_font_14 = fonts_get_system_font(FONT_KEY_GOTHIC_14);
+  s_font_18_bold = fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD);
+  s_font_28_bold = fonts_get_system_font(FONT_KEY_GOTHIC_28_BOLD);
+  s_font_42_bold = fonts_get_system_font(FONT_KEY_BITHAM_42_BOLD);
+
+  Layer *layer = layer_create(bounds);
+  layer_set_update_proc(layer, update_proc);
+  return layer;
+}
+
+void metrics_layer_destroy(Layer *layer) {
+  layer_destroy(layer);
+}
+
+// Mark changed metrics, only their regions are re-formatted, all of them are drawn. The redraws of
+// all the changes until the next frame are coalesced by the system, and skipped while the layer is
+// hidden.
+void metrics_layer_mark_dirty(Layer *layer, uint8_t regions) {
+  s_dirty |= regions;
+  layer_mark_dirty(layer);
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+// metrics layer functions prototypes
+
+// Main screen metrics (regions of the metrics layer)
+#define METRIC_TIME (1 << 0)
+#define METRIC_STROKES (1 << 1)
+#define METRIC_LAPS (1 << 2)
+#define METRIC_DISTANCE (1 << 3)
+#define METRIC_SWOLF (1 << 4)
+#define METRIC_MSG (1 << 5)
+#define METRIC_RATE (1 << 6)
+#define METRIC_ALL (METRIC_TIME | METRIC_STROKES | METRIC_LAPS | METRIC_DISTANCE | METRIC_SWOLF | METRIC_MSG | \
+                    METRIC_RATE)
+
+// The values drawn by the metrics layer
+typedef struct {
+  uint32_t elapsed_ms;
+  bool hundredths;
+  int strokes;
+  int stroke_rate;    // strokes per minute, 0 when not swimming
+  int laps;
+  int distance;
+  int swolf_avg;
+  const char *msg;
+} Metrics;
+
+Layer *metrics_layer_create(GRect bounds, Metrics *metrics);
+void metrics_layer_destroy(Layer *layer);
+void metrics_layer_mark_dirty(Layer *layer, uint8_t regions);
\ No newline at end of file
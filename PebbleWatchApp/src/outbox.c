@@ -0,0 +1,276 @@
+// outbox code
+//
+// Store and forward of the workout updates to the phone. The updates are queued and sent later
+// from a timer, never from the sensor callbacks, one message at a time: the next one leaves when
+// the phone acknowledged the previous one. A failed message is retried with a growing backoff,
+// the queued laps are then kept in persistent memory in case the link stays down, and several
+// queued laps are coalesced into one message when catching up. Each queued lap is tagged with its
+// workout, which keeps its id and totals: a workout that ended is still sent in full, with the
+// state it ended with, while the next one starts.
+
+#include <pebble.h>
+#include <feed.h>
+#include <laplog.h>
+#include <protocol.h>
+#include <outbox.h>
+#include <store.h>
+
+// Persistent memory layout, kept in the blob store
+#define OUTBOX_VERSION 3
+
+typedef struct {
+  uint8_t workout;          // number of its OutboxWorkout
+  LapRecord lap;
+} __attribute__((__packed__)) OutboxEntry;
+
+typedef struct {
+  uint8_t workouts;
+  uint8_t count;
+  OutboxWorkout workout[OUTBOX_WORKOUTS];  // oldest first, all saved
+  OutboxEntry entries[OUTBOX_CAPACITY];    // oldest first, only count of them are saved
+} __attribute__((__packed__)) OutboxQueue;
+
+#define OUTBOX_QUEUE_SIZE(count) (2 + OUTBOX_WORKOUTS * sizeof(OutboxWorkout) + (count) * sizeof(OutboxEntry))
+
+static uint32_t s_key;
+static OutboxWriter s_writer;
+
+// Workouts with data queued, oldest first, the last one gets the new pushes
+static OutboxWorkout s_workouts[OUTBOX_WORKOUTS];
+static int s_workout_count = 0;
+
+// Ring buffer of laps
+static OutboxEntry s_entries[OUTBOX_CAPACITY];
+static int s_head = 0;              // oldest lap
+static int s_count = 0;
+
+static int s_in_flight = -1;        // laps in the message waiting for its ack, -1 when none
+static uint8_t s_in_flight_workout; // number of the workout of that message
+static AppTimer *s_timer = NULL;
+static uint32_t s_retry_ms = OUTBOX_RETRY_MS;
+static bool s_saved = false;        // queued data kept in persistent memory
+static OutboxQueue s_queue;         // persistent memory buffer
+
+static void send_next(void *data);
+
+static void schedule(uint32_t delay_ms) {
+  if (s_timer == NULL && s_in_flight < 0) {
+    s_timer = app_timer_register(delay_ms, send_next, NULL);
+  }
+}
+
+// Laps or totals left to send
+static bool pending() {
+  for (int i = 0; i < s_workout_count; i++) {
+    if (s_workouts[i].state_pending) {
+      return true;
+    }
+  }
+  return s_count > 0;
+}
+
+static OutboxWorkout *find_workout(uint8_t number) {
+  for (int i = 0; i < s_workout_count; i++) {
+    if (s_workouts[i].number == number) {
+      return &s_workouts[i];
+    }
+  }
+  return NULL;
+}
+
+// Drop the oldest lap
+static void drop_lap() {
+  s_head = (s_head + 1) % OUTBOX_CAPACITY;
+  s_count--;
+  if (s_in_flight > 0) {
+    s_in_flight--;
+  }
+}
+
+// Drop the oldest workout when it has nothing left to send and a newer one took over, or with
+// all its laps when forced
+static void drop_workout(bool force) {
+  if (s_workout_count == 0 ||
+      (!force && (s_workout_count == 1 || s_workouts[0].state_pending ||
+                  (s_count > 0 && s_entries[s_head].workout == s_workouts[0].number)))) {
+    return;
+  }
+  while (s_count > 0 && s_entries[s_head].workout == s_workouts[0].number) {
+    drop_lap();
+  }
+  s_workout_count--;
+  memmove(&s_workouts[0], &s_workouts[1], s_workout_count * sizeof(OutboxWorkout));
+}
+
+// Build and send a message of the oldest workout and its oldest queued laps
+static void send_next(void *data) {
+  DictionaryIterator *iter;
+  LapRecord laps[OUTBOX_COALESCE];
+  OutboxWorkout *workout = &s_workouts[0];
+  int count = 0;
+
+  s_timer = NULL;
+  drop_workout(false);
+  if (s_workout_count == 0) {
+    return;
+  }
+  while (count < s_count && count < OUTBOX_COALESCE &&
+         s_entries[(s_head + count) % OUTBOX_CAPACITY].workout == workout->number) {
+    count++;
+  }
+  if (count == 0 && !workout->state_pending) {
+    return;
+  }
+
+  AppMessageResult result = app_message_outbox_begin(&iter);
+  if (result == APP_MSG_BUSY) {
+    schedule(OUTBOX_BUSY_MS);
+    return;
+  }
+  if (result != APP_MSG_OK) {
+    outbox_failed(result);
+    return;
+  }
+
+  for (int i = 0; i < count; i++) {
+    laps[i] = s_entries[(s_head + i) % OUTBOX_CAPACITY].lap;
+  }
+  s_writer(iter, workout, laps, count);
+
+  s_in_flight = count;
+  s_in_flight_workout = workout->number;
+  workout->state_pending = false;
+  result = app_message_outbox_send();
+  if (result != APP_MSG_OK) {
+    outbox_failed(result);
+  }
+}
+
+// Start sending the queued laps
+void outbox_init(uint32_t key, OutboxWriter writer) {
+  OutboxQueue *queue = &s_queue;
+  int length = store_length(key, OUTBOX_VERSION);
+
+  s_key = key;
+  s_writer = writer;
+  outbox_reset();
+
+  if (length >= (int)OUTBOX_QUEUE_SIZE(0) && length <= (int)sizeof(OutboxQueue) &&
+      store_read(key, OUTBOX_VERSION, queue, 0, length) &&
+      queue->workouts <= OUTBOX_WORKOUTS && queue->count <= OUTBOX_CAPACITY &&
+      length == (int)OUTBOX_QUEUE_SIZE(queue->count)) {
+    memcpy(s_workouts, queue->workout, sizeof(s_workouts));
+    s_workout_count = queue->workouts;
+    memcpy(s_entries, queue->entries, queue->count * sizeof(OutboxEntry));
+    s_count = queue->count;
+    s_saved = true;
+    schedule(0);
+  }
+}
+
+// Queue the totals of the workout, and a lap of it unless lap is NULL. The message is sent later.
+void outbox_push(const char *workout_id, const ProtocolState *totals, const LapRecord *lap) {
+  OutboxWorkout *workout = s_workout_count > 0 ? &s_workouts[s_workout_count - 1] : NULL;
+
+  if (workout == NULL || strncmp(workout->id, workout_id, sizeof(workout->id)) != 0) {
+    // A new workout, the ended ones keep their data until it is sent
+    uint8_t number = workout ? workout->number + 1 : 0;
+    if (s_workout_count == OUTBOX_WORKOUTS) {
+      drop_workout(true);
+    }
+    workout = &s_workouts[s_workout_count++];
+    memset(workout, 0, sizeof(OutboxWorkout));
+    workout->number = number;
+    strncpy(workout->id, workout_id, sizeof(workout->id) - 1);
+  }
+  workout->totals = *totals;
+  workout->state_pending = true;
+
+  if (lap) {
+    if (s_count == OUTBOX_CAPACITY) {
+      // The link is down for long, drop the oldest lap (the totals still count it)
+      drop_lap();
+    }
+    OutboxEntry *entry = &s_entries[(s_head + s_count) % OUTBOX_CAPACITY];
+    entry->workout = workout->number;
+    entry->lap = *lap;
+    s_count++;
+  }
+  schedule(0);
+}
+
+// The phone acknowledged the message in flight: drop its laps and send the next ones
+void outbox_sent() {
+  if (s_in_flight < 0) {
+    return;
+  }
+  s_head = (s_head + s_in_flight) % OUTBOX_CAPACITY;
+  s_count -= s_in_flight;
+  s_in_flight = -1;
+  s_retry_ms = OUTBOX_RETRY_MS;
+  drop_workout(false);
+
+  if (s_saved && !pending()) {
+    outbox_save(); // the saved data was all sent
+  }
+  schedule(0);
+}
+
+// The message was not delivered: keep its laps and totals and retry later
+void outbox_failed(AppMessageResult reason) {
+  OutboxWorkout *workout = s_in_flight >= 0 ? find_workout(s_in_flight_workout) : NULL;
+
+  if (workout) {
+    workout->state_pending = true; // the totals still have to be sent
+  }
+  s_in_flight = -1;
+
+  if (pending()) {
+    outbox_save(); // in case the link stays down until the app exits
+  }
+  schedule(s_retry_ms);
+  if (s_retry_ms < OUTBOX_RETRY_MAX_MS) {
+    s_retry_ms *= 2;
+  }
+}
+
+// Send the totals again, the phone lost those it had
+void outbox_resync() {
+  if (s_workout_count > 0) {
+    s_workouts[0].state_pending = true;
+    schedule(0);
+  }
+}
+
+// Drop all the queued workouts and laps
+void outbox_reset() {
+  if (s_timer) {
+    app_timer_cancel(s_timer);
+    s_timer = NULL;
+  }
+  s_workout_count = 0;
+  s_head = 0;
+  s_count = 0;
+  s_in_flight = -1;
+  s_retry_ms = OUTBOX_RETRY_MS;
+}
+
+// Write the queued workouts and laps to persistent memory
+void outbox_save() {
+  OutboxQueue *queue = &s_queue;
+
+  memset(queue->workout, 0, sizeof(queue->workout));
+  queue->workouts = s_workout_count;
+  memcpy(queue->workout, s_workouts, s_workout_count * sizeof(OutboxWorkout));
+  queue->count = s_count;
+  for (int i = 0; i < s_count; i++) {
+    queue->entries[i] = s_entries[(s_head + i) % OUTBOX_CAPACITY];
+  }
+  store_write(s_key, OUTBOX_VERSION, queue, OUTBOX_QUEUE_SIZE(s_count));
+  s_saved = pending();
+}
+
+// Number of laps not acknowledged yet
+int outbox_pending() {
+  return s_count;
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+// outbox functions prototypes (include laplog.h and protocol.h first)
+
+// Laps waiting to be sent, a new one replaces the oldest when the link stays down
+#define OUTBOX_CAPACITY 32
+// Workouts with data waiting, the ended one still being sent and the current one: a third one
+// drops the oldest
+#define OUTBOX_WORKOUTS 2
+// Most laps sent in one message when catching up
+#define OUTBOX_COALESCE 6
+// Retry backoff after a failed send, doubled on each failure
+#define OUTBOX_RETRY_MS 1000
+#define OUTBOX_RETRY_MAX_MS 32000
+// Retry delay while the outbox is busy with another message
+#define OUTBOX_BUSY_MS 200
+
+// A workout with data queued, 78 bytes
+typedef struct {
+  uint8_t number;           // tag of its laps in the queue
+  bool state_pending;       // totals pushed and not sent yet
+  char id[20];
+  ProtocolState totals;     // at the last push
+} __attribute__((__packed__)) OutboxWorkout;
+
+// Writes a message: the totals of the workout, and its queued laps (oldest first)
+typedef void (*OutboxWriter)(DictionaryIterator *iter, const OutboxWorkout *workout,
+                             const LapRecord *laps, int count);
+
+void outbox_init(uint32_t key, OutboxWriter writer);
+void outbox_push(const char *workout_id, const ProtocolState *totals, const LapRecord *lap);
+void outbox_sent();
+void outbox_failed(AppMessageResult reason);
+void outbox_resync();
+void outbox_reset();
+void outbox_save();
+int outbox_pending();
\ No newline at end of file
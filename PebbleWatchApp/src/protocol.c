@@ -0,0 +1,140 @@
+// workout update protocol code
+//
+// Each message to the phone holds one binary payload: the totals that changed since the last
+// message the phone acknowledged, as deltas, and the laps queued in the outbox. A lap then costs
+// a few dozen bytes over bluetooth. The phone keeps the states of the last sequences and applies
+// each payload to the base state it names (see src/js/pebble-js-app.js). The message also has
+// the totals in the keys of the message before the payload, as the companion app reads them.
+
+#include <pebble.h>
+#include <common.h>
+#include <feed.h>
+#include <laplog.h>
+#include <protocol.h>
+#include <outbox.h>
+
+static uint8_t s_payload[PROTOCOL_PAYLOAD_MAX(OUTBOX_COALESCE)];
+static char s_social[PROTOCOL_SOCIAL_SIZE];
+static uint8_t s_sequence = 0;         // of the last message written
+static ProtocolState s_acked;          // last state the phone acknowledged
+static uint8_t s_acked_sequence = PROTOCOL_NO_BASE;
+static ProtocolState s_sent;           // state of the message in flight
+static uint8_t s_sent_sequence = PROTOCOL_NO_BASE;
+static char s_workout_id[20];          // of the acknowledged state
+
+static uint8_t *write_varint(uint8_t *p, uint32_t value) {
+  while (value >= 0x80) {
+    *p++ = (value & 0x7f) | 0x80;
+    value >>= 7;
+  }
+  *p++ = value;
+  return p;
+}
+
+// Small negative values stay short
+static uint32_t zigzag(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+// Forget the acknowledged state, the next payload holds the full state (app start, or the first
+// message of another workout)
+void protocol_reset() {
+  memset(&s_acked, 0, sizeof(s_acked));
+  s_acked_sequence = PROTOCOL_NO_BASE;
+  s_sent_sequence = PROTOCOL_NO_BASE;
+}
+
+// Write the friend messages that came in since the last ack (a like each), the newest ones when
+// there are more than PROTOCOL_SOCIAL_MAX. Returns false when there is none.
+static bool write_social(const ProtocolState *state) {
+  int count = state->fields[PROTOCOL_LIKES] - s_acked.fields[PROTOCOL_LIKES];
+  char *p = s_social;
+
+  if (count > feed_count()) {
+    count = feed_count();
+  }
+  if (count > PROTOCOL_SOCIAL_MAX) {
+    count = PROTOCOL_SOCIAL_MAX;
+  }
+  for (int i = feed_count() - count; i < feed_count(); i++) {
+    const FeedMessage *message = feed_get(i);
+    p += snprintf(p, PROTOCOL_SOCIAL_LINE, "%s[%s]: %s", p == s_social ? "" : "\n", message->sender,
+                  message->text);
+  }
+  return count > 0;
+}
+
+static void write_total(DictionaryIterator *iter, uint32_t key, const int32_t *value) {
+  dict_write_int(iter, key, value, sizeof(int32_t), true);
+}
+
+// Write the totals as the message before the payload had them
+static void write_legacy(DictionaryIterator *iter, const ProtocolState *state, const char *workout_id) {
+  char duration[12];
+
+  dict_write_cstring(iter, PROTOCOL_WORKOUT_ID_KEY, workout_id);
+  update_elapsed_time(state->fields[PROTOCOL_ELAPSED_MS], duration, false);
+  dict_write_cstring(iter, PROTOCOL_DURATION_KEY, duration);
+  write_total(iter, PROTOCOL_STROKES_KEY, &state->fields[PROTOCOL_STROKES]);
+  write_total(iter, PROTOCOL_LAPS_KEY, &state->fields[PROTOCOL_LAPS]);
+  write_total(iter, PROTOCOL_LIKES_KEY, &state->fields[PROTOCOL_LIKES]);
+  dict_write_cstring(iter, PROTOCOL_SOCIAL_KEY, write_social(state) ? s_social : "");
+  write_total(iter, PROTOCOL_DISTANCE_KEY, &state->fields[PROTOCOL_DISTANCE]);
+  write_total(iter, PROTOCOL_POOL_KEY, &state->fields[PROTOCOL_POOL]);
+  write_total(iter, PROTOCOL_SWOLF_KEY, &state->fields[PROTOCOL_SWOLF_AVG]);
+  write_total(iter, PROTOCOL_SSI_KEY, &state->fields[PROTOCOL_SSI]);
+}
+
+// Write a message of the current state and the given laps
+void protocol_write(DictionaryIterator *iter, const ProtocolState *state, const char *workout_id,
+                    const LapRecord *laps, int count) {
+  uint8_t *p = s_payload;
+  uint8_t *mask;
+  uint16_t changed = 0;
+
+  if (strncmp(workout_id, s_workout_id, sizeof(s_workout_id)) != 0) {
+    protocol_reset();
+    strncpy(s_workout_id, workout_id, sizeof(s_workout_id) - 1);
+  }
+  s_sequence = (s_sequence + 1) % PROTOCOL_NO_BASE;
+  *p++ = PROTOCOL_VERSION;
+  *p++ = s_sequence;
+  *p++ = s_acked_sequence;
+  mask = p;
+  p += 2;
+  for (int i = 0; i < PROTOCOL_FIELDS; i++) {
+    int32_t delta = state->fields[i] - s_acked.fields[i];
+    if (delta != 0) {
+      changed |= 1 << i;
+      p = write_varint(p, zigzag(delta));
+    }
+  }
+  mask[0] = changed & 0xff;
+  mask[1] = changed >> 8;
+
+  *p++ = count;
+  for (int i = 0; i < count; i++) {
+    const LapRecord *previous = i > 0 ? &laps[i - 1] : NULL;
+    p = write_varint(p, laps[i].index - (previous ? previous->index : 0));
+    p = write_varint(p, laps[i].start_ms - (previous ? previous->start_ms : 0));
+    p = write_varint(p, laps[i].duration_ms);
+    p = write_varint(p, laps[i].strokes);
+    p = write_varint(p, laps[i].swolf);
+    p = write_varint(p, laps[i].stroke_type);
+  }
+
+  dict_write_data(iter, PROTOCOL_UPDATE_KEY, s_payload, p - s_payload);
+  write_legacy(iter, state, workout_id);
+
+  s_sent = *state;
+  s_sent_sequence = s_sequence;
+}
+
+// The phone acknowledged the last message written, the next deltas are against its state
+void protocol_acked() {
+  if (s_sent_sequence != PROTOCOL_NO_BASE) {
+    s_acked = s_sent;
+    s_acked_sequence = s_sent_sequence;
+    s_sent_sequence = PROTOCOL_NO_BASE;
+  }
+}
\ No newline at end of file
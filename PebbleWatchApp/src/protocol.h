@@ -0,0 +1,86 @@
+// workout update protocol functions prototypes (include laplog.h, feed.h and outbox.h first)
+
+// AppMessage keys, see appinfo.json. Keys 0 to 9 are those of the message before the payload,
+// still sent with each update, in full, for the companion app that reads them
+#define PROTOCOL_WORKOUT_ID_KEY 0
+#define PROTOCOL_DURATION_KEY 1        // "HH:MM:SS"
+#define PROTOCOL_STROKES_KEY 2
+#define PROTOCOL_LAPS_KEY 3
+#define PROTOCOL_LIKES_KEY 4
+#define PROTOCOL_SOCIAL_KEY 5          // the friend messages below, "" when none came in
+#define PROTOCOL_DISTANCE_KEY 6
+#define PROTOCOL_POOL_KEY 7
+#define PROTOCOL_SWOLF_KEY 8           // average
+#define PROTOCOL_SSI_KEY 9
+#define PROTOCOL_UPDATE_KEY 10         // the binary payload below
+#define PROTOCOL_RESYNC_KEY 11         // received: the phone lost its states, send the next in full
+#define PROTOCOL_FRIEND_NAME_KEY 13    // received
+#define PROTOCOL_FRIEND_MESSAGE_KEY 14 // received
+
+// Payload version, bumped on any change of the layout
+#define PROTOCOL_VERSION 3
+// No base state, the payload holds the full state
+#define PROTOCOL_NO_BASE 0xff
+
+// Workout totals, sent as deltas against the last acknowledged ones
+typedef enum {
+  PROTOCOL_ELAPSED_MS,
+  PROTOCOL_STROKES,
+  PROTOCOL_LAPS,
+  PROTOCOL_DISTANCE,
+  PROTOCOL_POOL,
+  PROTOCOL_SWOLF_AVG,
+  PROTOCOL_SSI,
+  PROTOCOL_LIKES,
+  PROTOCOL_SWOLF_SD,      // the lap statistics, see stats.h
+  PROTOCOL_SWOLF_BEST,
+  PROTOCOL_PACE_AVG,      // 1/10 s per 100m
+  PROTOCOL_PACE_BEST,
+  PROTOCOL_STROKES_AVG,
+  PROTOCOL_BEST_LAP,
+  PROTOCOL_FIELDS
+} ProtocolField;
+
+typedef struct {
+  int32_t fields[PROTOCOL_FIELDS];
+} ProtocolState;
+
+// Payload layout:
+//   version, sequence, base sequence (or PROTOCOL_NO_BASE), mask of the changed fields (2 bytes,
+//   little endian),
+//   a zigzag varint delta for each changed field, in ProtocolField order,
+//   number of laps, then for each lap the varints of: index and start_ms (deltas against the
+//   previous lap of the message, absolute for the first one), duration_ms, strokes, swolf,
+//   stroke type (StrokeType, see sensing.h)
+#define PROTOCOL_VARINT_MAX 5
+#define PROTOCOL_LAP_MAX (6 * PROTOCOL_VARINT_MAX)
+#define PROTOCOL_PAYLOAD_MAX(laps) (5 + PROTOCOL_FIELDS * PROTOCOL_VARINT_MAX + 1 + (laps) * PROTOCOL_LAP_MAX)
+
+// Dictionary buffer sizes, as dict_calc_buffer_size() computes them: a 1 byte header, and for
+// each tuple a 7 byte header (key, type, length) before its data
+#define PROTOCOL_DICT_SIZE(tuples, bytes) (1 + 7 * (tuples) + (bytes))
+
+// Longest friend name and message accepted from the phone (with their terminating 0), the
+// feed keeps shorter ones
+#define PROTOCOL_FRIEND_NAME_MAX 32
+#define PROTOCOL_FRIEND_MESSAGE_MAX 160
+
+// Friend messages sent with an update: the newest of those received since the last ack, one
+// "[sender]: text" line each, oldest first. The delta of PROTOCOL_LIKES tells how many came in.
+#define PROTOCOL_SOCIAL_MAX 3
+#define PROTOCOL_SOCIAL_LINE (FEED_SENDER_LEN + FEED_TEXT_LEN + 4)
+#define PROTOCOL_SOCIAL_SIZE (PROTOCOL_SOCIAL_MAX * PROTOCOL_SOCIAL_LINE)
+
+// Received: a friend name and message (a resync is smaller)
+#define PROTOCOL_INBOX_SIZE \
+  PROTOCOL_DICT_SIZE(2, PROTOCOL_FRIEND_NAME_MAX + PROTOCOL_FRIEND_MESSAGE_MAX)
+// Sent: the payload of the most laps coalesced, the workout id, the duration, 8 totals and the
+// friend messages, within the 636 bytes of outbox every watch has (OUTBOX_COALESCE and
+// PROTOCOL_SOCIAL_MAX keep it there)
+#define PROTOCOL_OUTBOX_SIZE \
+  PROTOCOL_DICT_SIZE(11, PROTOCOL_PAYLOAD_MAX(OUTBOX_COALESCE) + 20 + 9 + 8 * 4 + PROTOCOL_SOCIAL_SIZE)
+
+void protocol_reset();
+void protocol_write(DictionaryIterator *iter, const ProtocolState *state, const char *workout_id,
+                    const LapRecord *laps, int count);
+void protocol_acked();
\ No newline at end of file
@@ -2,6 +2,10 @@
 
 #include <pebble.h>
 #include <common.h>
+#include <sensing.h>
+#include <laplog.h>
+#include <stats.h>
+#include <history.h>
 
 // UI
 static Window *window_score;
@@ -9,6 +13,14 @@ static TextLayer *text_layer_app_name;
 static TextLayer *text_layer_ssi;
 static TextLayer *text_layer_msg;
 static TextLayer *text_layer_info;
+static TextLayer *text_layer_lap;
+static TextLayer *text_layer_stats;
+static TextLayer *text_layer_trend;
+static TextLayer *text_layer_rest;
+
+// The smiley and the rows of figures below it scroll between the message and the info row
+#define SCORE_ROW_H 16
+static ScrollLayer *scroll_layer;
 
 // SWOLF Score Improvement (SSI) Avatar
 static BitmapLayer *ssi_bitmap_layer;
@@ -16,7 +28,19 @@ static GBitmap *ssi_bitmap;
 
 // SWOLF Score variables
 static int ssi = 0;          // SSI: SWOLF Score Improvement
-static int *swolf_avg_prev;  // SWOLF score average of the last workout
+static uint32_t rested_ms = 0; // rests at the wall of the workout, off the stopwatch
+
+// Set the long middle click to reset the workout history, the SSI baselines
+static void select_long_click_handler(ClickRecognizerRef recognizer, void *context) {
+  history_reset();
+  vibes_long_pulse();
+  window_stack_remove(window_score, false); // Return to the stopwatch screen
+}
+
+// Subscribe the click function handlers
+static void click_config_provider(void *context) {
+  window_long_click_subscribe(BUTTON_ID_SELECT, 0, select_long_click_handler, NULL);
+}
 
 static void window_load(Window *window_score) {
 
@@ -39,7 +63,7 @@ static void window_load(Window *window_score) {
   layer_add_child(window_layer, text_layer_get_layer(text_layer_ssi));
 
   // Set the text of the motivational message layer
-  text_layer_msg = text_layer_create(GRect(0, 50, bounds.size.w, 40));
+  text_layer_msg = text_layer_create(GRect(0, 50, bounds.size.w, 32));
   text_layer_set_font(text_layer_msg, fonts_get_system_font(FONT_KEY_GOTHIC_28_BOLD)); 
   if (ssi > 0) {
     text_layer_set_text(text_layer_msg, "Hooray!");
@@ -49,8 +73,14 @@ static void window_load(Window *window_score) {
   text_layer_set_text_alignment(text_layer_msg, GTextAlignmentCenter);
   layer_add_child(window_layer, text_layer_get_layer(text_layer_msg));
 
-  // Show smiley
-  bounds = GRect(0, 58, bounds.size.w, 120);
+  // Show smiley, then the rows of figures below it
+  scroll_layer = scroll_layer_create(GRect(0, 82, bounds.size.w, 68));
+  scroll_layer_set_callbacks(scroll_layer, (ScrollLayerCallbacks) {
+    .click_config_provider = click_config_provider,
+  });
+  scroll_layer_set_click_config_onto_window(scroll_layer, window_score);
+  layer_add_child(window_layer, scroll_layer_get_layer(scroll_layer));
+  int16_t y = 60; // the smiley height
 
   // Load the image
   if (ssi > 0) {
@@ -60,14 +90,77 @@ static void window_load(Window *window_score) {
   }
 
   // Create a BitmapLayer
-  ssi_bitmap_layer = bitmap_layer_create(bounds);
+  ssi_bitmap_layer = bitmap_layer_create(GRect(0, 0, bounds.size.w, y));
 
   // Set the bitmap and compositing mode
   bitmap_layer_set_bitmap(ssi_bitmap_layer, ssi_bitmap);
   bitmap_layer_set_compositing_mode(ssi_bitmap_layer, GCompOpSet);
 
-  // Add to the Window
-  layer_add_child(window_layer, bitmap_layer_get_layer(ssi_bitmap_layer));
+  // Add to the scroll layer
+  scroll_layer_add_child(scroll_layer, bitmap_layer_get_layer(ssi_bitmap_layer));
+
+  // Display the SWOLF trend of the recent workouts
+  if (history_workouts(HISTORY_MONTH) > 0) {
+    static char s_buffer_trend[32];
+    char week[8] = "-";
+    if (history_workouts(HISTORY_WEEK) > 0) {
+      snprintf(week, sizeof(week), "%d", history_swolf_avg(HISTORY_WEEK));
+    }
+    snprintf(s_buffer_trend, sizeof(s_buffer_trend), "SWOLF 7d %s, 30d %d", week,
+             history_swolf_avg(HISTORY_MONTH));
+    text_layer_trend = text_layer_create(GRect(0, y, bounds.size.w, SCORE_ROW_H));
+    text_layer_set_background_color(text_layer_trend, GColorClear);
+    text_layer_set_text(text_layer_trend, s_buffer_trend);
+    text_layer_set_text_alignment(text_layer_trend, GTextAlignmentCenter);
+    scroll_layer_add_child(scroll_layer, text_layer_get_layer(text_layer_trend));
+    y += SCORE_ROW_H;
+  }
+
+  // Display the SWOLF statistics and the best split of the workout
+  const Stat *swolf_stat = stats_get(STATS_SWOLF);
+  if (swolf_stat->count > 0) {
+    static char s_buffer_stats[32];
+    snprintf(s_buffer_stats, sizeof(s_buffer_stats), "SWOLF %d\u00b1%d, best lap %d", (int)stat_mean(swolf_stat),
+             (int)stat_stddev(swolf_stat), stats_best_lap());
+    text_layer_stats = text_layer_create(GRect(0, y, bounds.size.w, SCORE_ROW_H));
+    text_layer_set_background_color(text_layer_stats, GColorClear);
+    text_layer_set_text(text_layer_stats, s_buffer_stats);
+    text_layer_set_text_alignment(text_layer_stats, GTextAlignmentCenter);
+    scroll_layer_add_child(scroll_layer, text_layer_get_layer(text_layer_stats));
+    y += SCORE_ROW_H;
+  }
+
+  // Display the last lap split
+  const LapRecord *last_lap = laplog_last();
+  if (last_lap) {
+    static const char *stroke_types[STROKE_TYPES] = { "", " Fr", " Bk", " Br", " Fl" };
+    static char s_buffer_lap[36];
+    uint32_t lap_s = last_lap->duration_ms / 1000;
+    snprintf(s_buffer_lap, sizeof(s_buffer_lap), "Lap %d: %d:%02d %dst S%d%s", last_lap->index,
+             (int)(lap_s / 60), (int)(lap_s % 60), last_lap->strokes, last_lap->swolf,
+             last_lap->stroke_type < STROKE_TYPES ? stroke_types[last_lap->stroke_type] : "");
+    text_layer_lap = text_layer_create(GRect(0, y, bounds.size.w, SCORE_ROW_H));
+    text_layer_set_background_color(text_layer_lap, GColorClear);
+    text_layer_set_text(text_layer_lap, s_buffer_lap);
+    text_layer_set_text_alignment(text_layer_lap, GTextAlignmentCenter);
+    scroll_layer_add_child(scroll_layer, text_layer_get_layer(text_layer_lap));
+    y += SCORE_ROW_H;
+  }
+
+  // Display the time rested at the wall
+  if (rested_ms >= 1000) {
+    static char s_buffer_rest[24];
+    uint32_t rest_s = rested_ms / 1000;
+    snprintf(s_buffer_rest, sizeof(s_buffer_rest), "Rested %d:%02d", (int)(rest_s / 60), (int)(rest_s % 60));
+    text_layer_rest = text_layer_create(GRect(0, y, bounds.size.w, SCORE_ROW_H));
+    text_layer_set_background_color(text_layer_rest, GColorClear);
+    text_layer_set_text(text_layer_rest, s_buffer_rest);
+    text_layer_set_text_alignment(text_layer_rest, GTextAlignmentCenter);
+    scroll_layer_add_child(scroll_layer, text_layer_get_layer(text_layer_rest));
+    y += SCORE_ROW_H;
+  }
+
+  scroll_layer_set_content_size(scroll_layer, GSize(bounds.size.w, y));
 
   // Display info message
   text_layer_info = text_layer_create(GRect(0, 150, bounds.size.w, 16));
@@ -77,32 +170,39 @@ static void window_load(Window *window_score) {
 
 }
 
-// Set the long middle click to reset the SWOLF score average history
-static void select_long_click_handler(ClickRecognizerRef recognizer, void *context) {
-  *swolf_avg_prev = 0;
-  vibes_long_pulse();
-  window_stack_remove(window_score, false); // Return to the stopwatch screen
-}
-
-// Subscribe the click function handlers
-static void click_config_provider(void *context) {
-  window_long_click_subscribe(BUTTON_ID_SELECT, 0, select_long_click_handler, NULL);
-}
-
 // Destroy UI on window unload to free up memory
 static void window_unload(Window *window_score) {
   text_layer_destroy(text_layer_app_name);
   text_layer_destroy(text_layer_ssi);
   text_layer_destroy(text_layer_msg);
+  if (text_layer_lap) {
+    text_layer_destroy(text_layer_lap);
+    text_layer_lap = NULL;
+  }
+  if (text_layer_stats) {
+    text_layer_destroy(text_layer_stats);
+    text_layer_stats = NULL;
+  }
+  if (text_layer_trend) {
+    text_layer_destroy(text_layer_trend);
+    text_layer_trend = NULL;
+  }
+  if (text_layer_rest) {
+    text_layer_destroy(text_layer_rest);
+    text_layer_rest = NULL;
+  }
+  text_layer_destroy(text_layer_info);
+  bitmap_layer_destroy(ssi_bitmap_layer);
+  gbitmap_destroy(ssi_bitmap);
+  scroll_layer_destroy(scroll_layer);
   window_destroy(window_score);
 }
 
 // Create the score screen UI
-void show_score(int ssi_in, int *swolf_avg_prev_in) {
+void show_score(int ssi_in, uint32_t rested_ms_in) {
   ssi = ssi_in;
-  swolf_avg_prev = swolf_avg_prev_in;
+  rested_ms = rested_ms_in;
   window_score = window_create();
-  window_set_click_config_provider(window_score, click_config_provider);
   window_set_window_handlers(window_score, (WindowHandlers) {
     .load = window_load,
     .unload = window_unload,
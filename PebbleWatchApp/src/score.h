@@ -1,3 +1,3 @@
 // score screen functions prototypes
 
-void show_score(int, int *);
\ No newline at end of file
+void show_score(int, uint32_t);
\ No newline at end of file
@@ -0,0 +1,51 @@
+// background sensing messages, shared by the app and the worker (see worker_src/ubiswim_worker.c)
+
+typedef enum {
+  // worker -> app
+  SENSING_READY = 1,   // the worker started, waiting for SENSING_START
+  SENSING_COUNTS,      // data0: strokes, data1: laps, data2: strokes of the current lap
+  SENSING_LAP,         // data0: lap number, data1: ms since the turn, data2: SENSING_LAP_DATA2 below
+  SENSING_REST,        // the swimmer rests, data0: ms since the rest started
+  SENSING_RESUME,      // moving again after a rest, data1 | data2 << 16: SENSING_RESTED_MS below
+  SENSING_TEMPO,       // data0: strokes per minute, 0 when not swimming. Sent when it changes
+  // app -> worker
+  SENSING_START,       // start or resume counting from data0: strokes, data1: laps, data2: strokes of the current lap
+  SENSING_PAUSE,
+  SENSING_SYNC,        // data1: laps of the app. The worker replies the SENSING_LAP_LOGGED after them, then
+                       // SENSING_COUNTS and SENSING_SYNCED
+  SENSING_RECORD,      // data0: 1 to record the raw sensor samples to DataLogging, 0 to stop
+  // worker -> app
+  SENSING_LAP_LOGGED,  // a lap counted while the app was closed, data0: lap number, data1: duration in
+                       // 1/10 s, data2: SENSING_LAP_DATA2 below
+  SENSING_SYNCED       // the end of the SENSING_SYNC reply, the messages after it are live again.
+                       // data0: SensingState, data1 | data2 << 16: SENSING_RESTED_MS below
+} SensingMessage;
+
+// What the worker does, in its SENSING_SYNCED reply
+typedef enum {
+  SENSING_PAUSED = 0,  // paused by the app, or never started
+  SENSING_RUNNING,
+  SENSING_RESTING
+} SensingState;
+
+// Rest time of the workout in ms, of the rests ended by a push-off and the rest in progress: the app
+// takes off the stopwatch the part it did not see
+#define SENSING_RESTED_MS(data1, data2) ((uint32_t)(data1) | (uint32_t)(data2) << 16)
+
+// Laps the worker keeps for the app, the older ones are only in the counts
+#define SENSING_LAP_LOG 32
+
+// Stroke type of a lap, the one most of its strokes were classified as (see worker_src/stroketype.c)
+typedef enum {
+  STROKE_UNKNOWN = 0,
+  STROKE_FREE,
+  STROKE_BACK,
+  STROKE_BREAST,
+  STROKE_FLY,
+  STROKE_TYPES
+} StrokeType;
+
+// data2 of SENSING_LAP: the strokes of the lap (up to 255) and its stroke type
+#define SENSING_LAP_DATA2(strokes, type) (((strokes) < 255 ? (strokes) : 255) | ((type) << 8))
+#define SENSING_LAP_STROKES(data2) ((data2) & 0xff)
+#define SENSING_LAP_TYPE(data2) ((StrokeType)((data2) >> 8))
\ No newline at end of file
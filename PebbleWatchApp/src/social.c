@@ -2,6 +2,13 @@
 
 #include <pebble.h>
 #include <common.h>
+#include <feed.h>
+
+// Initialize text area on social screen
+#define SOCIAL_INIT_STR "Well, there are no messages received yet. Keep going and I'' ll vibe you when something comes up even while you swim!"
+
+// Space between messages
+#define MESSAGE_MARGIN 4
 
 // UI
 static Window *window;
@@ -9,48 +16,94 @@ static TextLayer *text_layer_app_name;
 static TextLayer *text_layer_likes;
 static TextLayer *text_layer_msg;
 
-// Scroll layer for displaying social "likes"
-static ScrollLayer *s_scroll_layer;
-
-// Text layer to scroll in the scroll layer
-static TextLayer *s_text_layer;
+// Menu layer for displaying social "likes", one row per message of the feed. Only the rows on
+// screen are drawn, and each row is measured once, so opening and scrolling the screen costs
+// the same however many messages there are.
+static MenuLayer *s_menu_layer;
+static uint8_t s_row_heights[FEED_CAPACITY]; // 0 until measured
+static GFont s_font_sender;
+static GFont s_font_text;
 static int likes_int = 0;
 static char likes_str[20] = "";
 
-// Create a 2000 characters long empty string
-static char s_scroll_text[] = "                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                ";
-
 // Function prototypes
-static void click_config_provider_updown(void *context);
 static void update_likes(void);
-static void update_social(void);
+
+// Height of a text drawn in the given width
+static int16_t text_height(const char *text, GFont font, int16_t w) {
+  return graphics_text_layout_get_content_size(text, font, GRect(0, 0, w, 2000),
+                                               GTextOverflowModeWordWrap, GTextAlignmentLeft).h;
+}
+
+// Draw a message (or measure it, when ctx is NULL), returns its height
+static int16_t draw_message(GContext *ctx, const FeedMessage *message, int16_t w) {
+  char sender[FEED_SENDER_LEN + 3];
+  snprintf(sender, sizeof(sender), "[%s]:", message->sender);
+
+  int16_t sender_h = text_height(sender, s_font_sender, w);
+  int16_t text_h = text_height(message->text, s_font_text, w);
+
+  if (ctx) {
+    graphics_draw_text(ctx, sender, s_font_sender, GRect(0, 0, w, sender_h),
+                       GTextOverflowModeWordWrap, GTextAlignmentLeft, NULL);
+    graphics_draw_text(ctx, message->text, s_font_text, GRect(0, sender_h, w, text_h),
+                       GTextOverflowModeWordWrap, GTextAlignmentLeft, NULL);
+  }
+  return sender_h + text_h + MESSAGE_MARGIN;
+}
+
+// Select BT click handler
+static void select_click_handler(MenuLayer *menu_layer, MenuIndex *cell_index, void *context) {
+  APP_LOG(APP_LOG_LEVEL_INFO, "Select BT");
+}
+
+static uint16_t get_num_rows(MenuLayer *menu_layer, uint16_t section_index, void *context) {
+  return feed_count() > 0 ? feed_count() : 1; // the init message when there are no messages
+}
+
+static int16_t get_cell_height(MenuLayer *menu_layer, MenuIndex *cell_index, void *context) {
+  int16_t w = layer_get_bounds(menu_layer_get_layer(menu_layer)).size.w;
+
+  if (feed_count() == 0) {
+    return text_height(SOCIAL_INIT_STR, s_font_text, w);
+  }
+  if (s_row_heights[cell_index->row] == 0) {
+    s_row_heights[cell_index->row] = draw_message(NULL, feed_get(cell_index->row), w);
+  }
+  return s_row_heights[cell_index->row];
+}
+
+static void draw_row(GContext *ctx, const Layer *cell_layer, MenuIndex *cell_index, void *context) {
+  int16_t w = layer_get_bounds(cell_layer).size.w;
+
+  if (feed_count() == 0) {
+    graphics_draw_text(ctx, SOCIAL_INIT_STR, s_font_text, layer_get_bounds(cell_layer),
+                       GTextOverflowModeWordWrap, GTextAlignmentLeft, NULL);
+    return;
+  }
+  draw_message(ctx, feed_get(cell_index->row), w);
+}
 
 static void window_load(Window *window) {
 
   Layer *window_layer = window_get_root_layer(window);
   GRect bounds = layer_get_bounds(window_layer);
-  GRect max_text_bounds = GRect(0, 0, bounds.size.w, 2000);
-
-  // Initialize the scroll layer
-  s_scroll_layer = scroll_layer_create(GRect(0, 55, bounds.size.w, 98));
-
-  // This binds the scroll layer to the window so that up and down map to scrolling
-  // You may use scroll_layer_set_callbacks to add or override interactivity
-  scroll_layer_set_click_config_onto_window(s_scroll_layer, window);
-  
-  // Initialize the social messages scrolling text layer
-  s_text_layer = text_layer_create(max_text_bounds);
-  text_layer_set_text(s_text_layer, s_scroll_text);
-  text_layer_set_font(s_text_layer, fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD));
 
-  // Trim text layer and scroll content to fit text box
-  GSize max_size = text_layer_get_content_size(s_text_layer);
-  text_layer_set_size(s_text_layer, max_size);
-  scroll_layer_set_content_size(s_scroll_layer, GSize(bounds.size.w, max_size.h + 4));
+  // Initialize the menu layer, the rows are measured when first shown
+  s_font_sender = fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD);
+  s_font_text = fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD);
+  memset(s_row_heights, 0, sizeof(s_row_heights));
+  s_menu_layer = menu_layer_create(GRect(0, 55, bounds.size.w, 98));
+  menu_layer_set_callbacks(s_menu_layer, NULL, (MenuLayerCallbacks) {
+    .get_num_rows = get_num_rows,
+    .get_cell_height = get_cell_height,
+    .draw_row = draw_row,
+    .select_click = select_click_handler,
+  });
 
-  // Add the layers for display
-  scroll_layer_add_child(s_scroll_layer, text_layer_get_layer(s_text_layer));
-  layer_add_child(window_layer, scroll_layer_get_layer(s_scroll_layer));
+  // This binds the menu layer to the window so that up and down map to scrolling
+  menu_layer_set_click_config_onto_window(s_menu_layer, window);
+  layer_add_child(window_layer, menu_layer_get_layer(s_menu_layer));
 
   // Set the text of the application name layer
   text_layer_app_name = text_layer_create(GRect(0, 0, bounds.size.w, 20));
@@ -71,51 +124,38 @@ static void window_load(Window *window) {
   text_layer_set_text_alignment(text_layer_msg, GTextAlignmentCenter);
   layer_add_child(window_layer, text_layer_get_layer(text_layer_msg));
 
-  // Set the click config provider for the scrolling text layer
-  scroll_layer_set_callbacks(s_scroll_layer, (ScrollLayerCallbacks) {
-        .click_config_provider = &click_config_provider_updown
-      });
-
-  // 1st update of likes and social text layers
+  // 1st update of likes text layer
   update_likes();
-  update_social();
  }
 
-// Select BT click handler
-static void select_click_handler(ClickRecognizerRef recognizer, void *context) {
-  APP_LOG(APP_LOG_LEVEL_INFO, "Select BT");
-}
-
-// Select BT click config provider
-static void click_config_provider_updown(void *context) {
-  window_single_click_subscribe(BUTTON_ID_SELECT, select_click_handler);
-}
-
 // Update the likes displayed counter
 static void update_likes() {
   snprintf(likes_str, 20, "Likes:%d", likes_int);
   text_layer_set_text(text_layer_likes, likes_str);
 }
 
-// Update the displayed social messages
-static void update_social() {
-  text_layer_set_text(s_text_layer, s_scroll_text);
-}
-
 // Destroy UI on window unload (when the user clicks the back button on Pebble) to free up memory
-static void window_unload(Window *window) {
+static void window_unload(Window *window_social) {
   text_layer_destroy(text_layer_app_name);
   text_layer_destroy(text_layer_likes);
   text_layer_destroy(text_layer_msg);
-  text_layer_destroy(s_text_layer);
-  scroll_layer_destroy(s_scroll_layer);
-  window_destroy(window);
+  menu_layer_destroy(s_menu_layer);
+  s_menu_layer = NULL;
+  window_destroy(window_social);
+  window = NULL; // the feed may change after the screen is closed, see social_feed_changed()
+}
+
+// Forget the measured rows after the feed changed, rows move up when the oldest is dropped
+void social_feed_changed() {
+  memset(s_row_heights, 0, sizeof(s_row_heights));
+  if (window && s_menu_layer && window_stack_contains_window(window)) {
+    menu_layer_reload_data(s_menu_layer);
+  }
 }
 
 // Create the social screen UI
-void show_social(int likes, char * social) {
+void show_social(int likes) {
   likes_int = likes;
-  strcpy(s_scroll_text, social);
   window = window_create();
   window_set_window_handlers(window, (WindowHandlers) {
     .load = window_load,
@@ -1,3 +1,4 @@
 // social screen functions prototypes
 
-void show_social(int, char *);
\ No newline at end of file
+void show_social(int);
+void social_feed_changed();
\ No newline at end of file
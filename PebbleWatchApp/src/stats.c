@@ -0,0 +1,87 @@
+// workout statistics code
+//
+// The mean, variance, min and max of the lap metrics, updated in O(1) per lap with Welford's
+// algorithm: no rescan of the laps (the lap log only keeps the last ones anyway), and no float.
+// The means are kept in 1/STATS_SCALE units, so rounding them on every lap does not drift.
+
+#include <pebble.h>
+#include <common.h>
+#include <stats.h>
+
+static WorkoutStats s_stats;
+
+// Forget all the laps (new workout)
+void stats_reset() {
+  memset(&s_stats, 0, sizeof(s_stats));
+}
+
+// Division rounded to the nearest, away from 0 on ties
+static int64_t div_round(int64_t numerator, int64_t denominator) {
+  return (numerator + (numerator < 0 ? -denominator : denominator) / 2) / denominator;
+}
+
+static void stat_add(Stat *stat, int32_t value) {
+  int64_t scaled = (int64_t)value * STATS_SCALE;
+
+  if (stat->count == 0 || value < stat->min) {
+    stat->min = value;
+  }
+  if (stat->count == 0 || value > stat->max) {
+    stat->max = value;
+  }
+  stat->count++;
+
+  int64_t delta = scaled - stat->mean;
+  stat->mean += div_round(delta, stat->count);
+  stat->m2 += delta * (scaled - stat->mean);
+}
+
+// Add a lap
+void stats_add_lap(int index, uint32_t duration_ms, int strokes, int swolf, int pool) {
+  stat_add(&s_stats.fields[STATS_SWOLF], swolf);
+  stat_add(&s_stats.fields[STATS_STROKES], strokes);
+  if (pool > 0) {
+    stat_add(&s_stats.fields[STATS_PACE], duration_ms / pool); // ms * 100m / pool, in 1/10 s
+  }
+  if (s_stats.best_lap == 0 || duration_ms < s_stats.best_lap_ms) {
+    s_stats.best_lap = index;
+    s_stats.best_lap_ms = duration_ms;
+  }
+}
+
+const Stat *stats_get(StatsField field) {
+  return &s_stats.fields[field];
+}
+
+// Index of the fastest lap, 0 before the first lap
+int stats_best_lap() {
+  return s_stats.best_lap;
+}
+
+uint32_t stats_best_lap_ms() {
+  return s_stats.best_lap_ms;
+}
+
+// Rounded mean, 0 before the first value
+int32_t stat_mean(const Stat *stat) {
+  return div_round(stat->mean, STATS_SCALE);
+}
+
+// Sample standard deviation (rounded down), 0 before the second value
+int32_t stat_stddev(const Stat *stat) {
+  if (stat->count < 2) {
+    return 0;
+  }
+  int64_t variance = stat->m2 / (stat->count - 1) / ((int64_t)STATS_SCALE * STATS_SCALE);
+  return isqrt(variance < UINT32_MAX ? variance : UINT32_MAX);
+}
+
+// Copy the statistics out, to be kept in persistent memory
+void stats_save(WorkoutStats *stats) {
+  *stats = s_stats;
+}
+
+// Restore the statistics of a workout in progress
+void stats_load(const WorkoutStats *stats) {
+  s_stats = *stats;
+}
\ No newline at end of file
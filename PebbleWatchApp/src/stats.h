@@ -0,0 +1,37 @@
+// workout statistics functions prototypes
+
+// Fixed point of the running means, in 1/STATS_SCALE units
+#define STATS_SCALE 256
+
+// Running statistic of a lap metric (Welford's algorithm, in integers)
+typedef struct {
+  uint16_t count;
+  int32_t min;
+  int32_t max;
+  int32_t mean;   // x STATS_SCALE
+  int64_t m2;     // sum of the squared deviations from the mean, x STATS_SCALE²
+} __attribute__((__packed__)) Stat;
+
+typedef enum {
+  STATS_SWOLF,     // strokes + seconds of a lap, on a 25m basis
+  STATS_PACE,      // tenths of a second per 100m
+  STATS_STROKES,   // strokes per lap
+  STATS_FIELDS
+} StatsField;
+
+// All the statistics of the workout, 72 bytes, kept in the workout state
+typedef struct {
+  Stat fields[STATS_FIELDS];
+  uint16_t best_lap;         // index of the fastest lap, 0 before the first lap
+  uint32_t best_lap_ms;
+} __attribute__((__packed__)) WorkoutStats;
+
+void stats_reset();
+void stats_add_lap(int index, uint32_t duration_ms, int strokes, int swolf, int pool);
+const Stat *stats_get(StatsField field);
+int stats_best_lap();
+uint32_t stats_best_lap_ms();
+int32_t stat_mean(const Stat *stat);
+int32_t stat_stddev(const Stat *stat);
+void stats_save(WorkoutStats *stats);
+void stats_load(const WorkoutStats *stats);
\ No newline at end of file
@@ -0,0 +1,153 @@
+// blob store code
+//
+// Keeps blobs bigger than a persist value (256 bytes) in consecutive keys: a header at the key,
+// then two slots per chunk at key + 1 + 2 * chunk + slot. The header holds the version and length
+// of the blob, the slot and the CRC of each chunk, so a write only touches the chunks that changed
+// and a read only the chunks asked for.
+//
+// A save writes the changed chunks to their other slot and then the header, in one persist write:
+// until then the old header still points at the old chunks, a save cut short loses nothing.
+
+#include <pebble.h>
+#include <store.h>
+
+typedef struct {
+  uint16_t crc;                         // of the rest of the header
+  uint8_t version;
+  uint8_t chunks;
+  uint16_t length;
+  uint8_t slots;                        // bit i: the slot of chunk i, fits STORE_MAX_CHUNKS
+  uint16_t chunk_crc[STORE_MAX_CHUNKS];
+} __attribute__((__packed__)) StoreHeader;
+
+// Chunk buffer for the reads that do not cover a whole chunk
+static uint8_t s_chunk[STORE_CHUNK_SIZE];
+
+// CRC-16/CCITT, a nibble at a time
+static uint16_t crc16(uint16_t crc, const uint8_t *data, uint16_t length) {
+  static const uint16_t table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef
+  };
+  for (uint16_t i = 0; i < length; i++) {
+    crc = (crc << 4) ^ table[(crc >> 12) ^ (data[i] >> 4)];
+    crc = (crc << 4) ^ table[(crc >> 12) ^ (data[i] & 0x0f)];
+  }
+  return crc;
+}
+
+static uint16_t header_crc(const StoreHeader *header) {
+  return crc16(0xffff, (const uint8_t *)header + sizeof(header->crc),
+               sizeof(StoreHeader) - sizeof(header->crc));
+}
+
+static uint32_t chunk_key(uint32_t key, const StoreHeader *header, int chunk) {
+  return key + 1 + 2 * chunk + ((header->slots >> chunk) & 1);
+}
+
+// Read and check a header, false when there is no valid blob of this version at the key
+static bool read_header(uint32_t key, uint8_t version, StoreHeader *header) {
+  return persist_read_data(key, header, sizeof(StoreHeader)) == sizeof(StoreHeader) &&
+         header->version == version && header->chunks <= STORE_MAX_CHUNKS &&
+         header->length <= header->chunks * STORE_CHUNK_SIZE &&
+         header->crc == header_crc(header);
+}
+
+static uint16_t chunk_length(uint16_t length, int chunk) {
+  uint16_t left = length - chunk * STORE_CHUNK_SIZE;
+  return left < STORE_CHUNK_SIZE ? left : STORE_CHUNK_SIZE;
+}
+
+// Write a blob, only the chunks that differ from the stored ones are written
+bool store_write(uint32_t key, uint8_t version, const void *data, uint16_t length) {
+  StoreHeader old;
+  StoreHeader header;
+  uint8_t written = 0;  // chunks written to their other slot
+
+  memset(&header, 0, sizeof(header));
+  header.version = version;
+  header.length = length;
+  header.chunks = (length + STORE_CHUNK_SIZE - 1) / STORE_CHUNK_SIZE;
+  if (header.chunks > STORE_MAX_CHUNKS) {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "store: %d bytes do not fit at key %d", length, (int)key);
+    return false;
+  }
+  if (!read_header(key, version, &old)) {
+    memset(&old, 0, sizeof(old));
+  }
+
+  for (int i = 0; i < header.chunks; i++) {
+    const uint8_t *chunk = (const uint8_t *)data + i * STORE_CHUNK_SIZE;
+    uint16_t size = chunk_length(length, i);
+
+    header.chunk_crc[i] = crc16(0xffff, chunk, size);
+    header.slots |= old.slots & (1 << i);
+    if (i >= old.chunks || old.chunk_crc[i] != header.chunk_crc[i] ||
+        size != chunk_length(old.length, i)) {
+      header.slots ^= 1 << i;
+      written |= 1 << i;
+      if (persist_write_data(chunk_key(key, &header, i), chunk, size) < 0) {
+        return false;
+      }
+    }
+  }
+  header.crc = header_crc(&header);
+
+  if (old.chunks != 0 && memcmp(&old, &header, sizeof(header)) == 0) {
+    return true;
+  }
+  if (persist_write_data(key, &header, sizeof(header)) < 0) {
+    return false;
+  }
+
+  // The old slots of the chunks written, and the chunks past the new end
+  for (int i = 0; i < old.chunks; i++) {
+    if (i >= header.chunks || (written & (1 << i))) {
+      persist_delete(chunk_key(key, &old, i));
+    }
+  }
+  return true;
+}
+
+// Length of the blob at the key, -1 when there is none of this version
+int store_length(uint32_t key, uint8_t version) {
+  StoreHeader header;
+
+  return read_header(key, version, &header) ? header.length : -1;
+}
+
+// Read a part of a blob, only the chunks covering it are read and checked
+bool store_read(uint32_t key, uint8_t version, void *data, uint16_t offset, uint16_t length) {
+  StoreHeader header;
+
+  if (!read_header(key, version, &header) || offset + length > header.length) {
+    return false;
+  }
+
+  uint8_t *out = data;
+  while (length > 0) {
+    int chunk = offset / STORE_CHUNK_SIZE;
+    uint16_t start = offset % STORE_CHUNK_SIZE;
+    uint16_t size = chunk_length(header.length, chunk);
+    uint16_t count = size - start < length ? size - start : length;
+
+    if (persist_read_data(chunk_key(key, &header, chunk), s_chunk, size) != size ||
+        crc16(0xffff, s_chunk, size) != header.chunk_crc[chunk]) {
+      return false;
+    }
+    memcpy(out, s_chunk + start, count);
+
+    out += count;
+    offset += count;
+    length -= count;
+  }
+  return true;
+}
+
+// Delete a blob and all its chunks
+void store_delete(uint32_t key) {
+  for (int i = 0; i < 2 * STORE_MAX_CHUNKS; i++) {
+    persist_delete(key + 1 + i);
+  }
+  persist_delete(key);
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+// blob store functions prototypes
+
+// A blob is split in chunks of the persist value size, at the keys after its header key. Each chunk
+// has two slots, a save writes the changed chunks to their free slot and switches to them in the
+// header last, the old slot is deleted after.
+#define STORE_CHUNK_SIZE 256   // PERSIST_DATA_MAX_LENGTH
+#define STORE_MAX_CHUNKS 8     // up to 2KB per blob, keys: header key + 1 + 2 * STORE_MAX_CHUNKS
+
+// The app has 4KB of persistent storage. The blobs take (FEED_PKEY, OUTBOX_PKEY, HISTORY_PKEY):
+//   feed     1090 bytes (FEED_CAPACITY messages)
+//   outbox    up to 606 bytes (OUTBOX_CAPACITY laps, OUTBOX_WORKOUTS workouts)
+//   history   539 bytes (HISTORY_CAPACITY workouts)
+// with the workout checkpoint (WORKOUT_PKEY) about 2.4KB, and a save needs room for a
+// second copy of the chunks it changes.
+
+bool store_write(uint32_t key, uint8_t version, const void *data, uint16_t length);
+int store_length(uint32_t key, uint8_t version);
+bool store_read(uint32_t key, uint8_t version, void *data, uint16_t offset, uint16_t length);
+void store_delete(uint32_t key);
\ No newline at end of file
@@ -3,108 +3,122 @@
 #include <pebble.h>
 #include <common.h>
 #include <social.h>
+#include <feed.h>
 #include <pool.h>
 #include <splash.h>
 #include <score.h>
-
-// Accelerometer tuning constants 
-#define ACCEL_SAMPLING_RATE ACCEL_SAMPLING_10HZ
-#define ACCEL_SAMPLES_PER_CALLBACK 1
-#define ACCEL_THRESHOLD 180
-#define ACCEL_DURATION 35
-
-// Compass tuning constants
-#define COMPASS_DURATION 40 // 40degreeValues / 4degreeValuesPerSec = 10sec (to detect direction change)
-#define COMPASS_ALPHA 0.02 // Used in the Low Pass Filter calculation
+#include <sensing.h>
+#include <metrics.h>
+#include <laplog.h>
+#include <protocol.h>
+#include <outbox.h>
+#include <stats.h>
+#include <history.h>
 
 // Persistent memory keys
-#define WORKOUT_ID_PKEY 0
-#define STATE_PKEY 1
+#define WORKOUT_ID_PKEY 0 // no longer used, migrated to WORKOUT_PKEY
+#define STATE_PKEY 1      // no longer used, migrated to WORKOUT_PKEY
 #define ELAPSED_TIME_PKEY 2
 #define STROKES_PKEY 3
 #define LAPS_PKEY 4
-#define LIKES_PKEY 5
-#define SOCIAL_PKEY 6
-#define SWOLF_PREV_PKEY 7
-
-// AppMessage Keys
-#define WORKOUT_ID_KEY 0
-#define DURATION_KEY 1
-#define STROKES_KEY 2
-#define LAPS_KEY 3
-#define LIKES_KEY 4
-#define SOCIAL_KEY 5
-#define DISTANCE_KEY 6
-#define POOL_KEY 7
-#define SWOLF_KEY 8
-#define SSI_KEY 9
-
-// Initialize text area on social screen
-#define SOCIAL_INIT_STR "Well, there are no messages received yet. Keep going and I'' ll vibe you when something comes up even while you swim!"
-
-// Used for stopwatch persistent memory managment
-struct StopwatchState {
-  double elapsed_time;
+#define LIKES_PKEY 5      // no longer used, migrated to WORKOUT_PKEY
+#define SOCIAL_PKEY 6     // no longer used, replaced by FEED_PKEY
+#define SWOLF_PREV_PKEY 7 // no longer used, replaced by HISTORY_PKEY
+#define WORKOUT_PKEY 8
+#define RECORD_PKEY 9
+#define OUTBOX_PKEY 200 // and the blob store chunks after it
+#define FEED_PKEY 100 // and the blob store chunks after it
+#define HISTORY_PKEY 300 // and the blob store chunks after it
+
+// Show the hundredths of the elapsed time (the stopwatch then ticks every 100ms while on screen)
+#define STOPWATCH_HUNDREDTHS true
+
+// Checkpoint the running workout every 30 seconds, and on every lap
+#define CHECKPOINT_INTERVAL_MS 30000
+
+// The workout in progress, kept in persistent memory so it survives a crash or reboot
+#define WORKOUT_STATE_VERSION 4
+
+typedef struct {
+  uint8_t version;
+  char workout_id[20];      // empty when the workout has been completed
+  uint32_t elapsed_ms;
+  uint32_t lap_elapsed_ms;  // time into the current lap
+  uint16_t strokes;
+  uint16_t strokes_of_lap;
+  uint16_t laps;
+  uint16_t likes;
+  uint8_t pool;
+  int64_t running_at;       // clock_ms() the times were taken at while running, 0 when paused
+  WorkoutStats stats;
+  uint8_t resting;          // running_at is the start of the rest
+  uint32_t rested_ms;       // SENSING_RESTED_MS of the worker at running_at
+} __attribute__((__packed__)) WorkoutState;
+
+// Version 3 is version 4 without its last fields
+#define WORKOUT_STATE_V3_SIZE (sizeof(WorkoutState) - sizeof(uint8_t) - sizeof(uint32_t))
+
+// The workout state of versions 1 and 2 (2 added running_at after it), migrated to the current one
+typedef struct {
+  uint8_t version;
+  char workout_id[20];
+  uint32_t elapsed_ms;
+  uint32_t lap_elapsed_ms;
+  uint16_t strokes;
+  uint16_t strokes_of_lap;
+  uint16_t laps;
+  uint16_t swolf_avg;       // old SWOLF formula, not comparable with the stats
+  uint16_t likes;
+  uint8_t pool;
+} __attribute__((__packed__)) WorkoutStateV1;
+
+// The workout state before the versions, at STATE_PKEY with the id at WORKOUT_ID_PKEY and the
+// likes at LIKES_PKEY
+typedef struct {
+  double elapsed_time;      // ms
   int strokes;
   int laps;
   int swolf_avg;
   int pool;
-} __attribute__((__packed__));
+} __attribute__((__packed__)) StopwatchState;
 
 // Application's main screen UI (counters screen)
 static Window *window;
-static TextLayer *text_layer_app_name;
-static TextLayer *text_layer_elapsed_time;
-static TextLayer *text_layer_strokes;
-static TextLayer *text_layer_laps;
-static TextLayer *text_layer_distance;
-static TextLayer *text_layer_msg;
-static TextLayer *text_layer_m;
-static TextLayer *text_layer_swolf_avg;
+static Layer *metrics_layer;
+static Metrics metrics = { .hundredths = STOPWATCH_HUNDREDTHS, .msg = "U:Start M:Score D:Send" };
+static bool window_visible = false;  // false while another window (score, social, pool) covers it
 
 // Timer variables
 static AppTimer* update_timer = NULL;
-static double elapsed_time = 0;
-static double lap_time = 0;
-static double lap_start_time = 0;
-static double start_time = 0;
-static double pause_time = 0;
-static double interval = 0;
-static char elapsed_time_str[12] = "00:00:00.00";
+static bool ticking = false;   // 1Hz tick timer subscribed
+static uint32_t elapsed_time = 0;  // ms, of the workout without the pauses
+static uint32_t lap_time = 0;      // ms, of the current lap
+static int64_t lap_start_time = 0; // clock_ms() times, moved forward by the pauses
+static int64_t start_time = 0;
+static int64_t pause_time = 0;
+static int64_t interval = 0;
 static bool started = false;
-
-// SWOLF variables
-static char swolf_avg_str[12] = "SWOLF: 00";
+static bool resting = false;   // paused by the worker while the swimmer rests at the wall
+static uint32_t rested_ms = 0; // rest time the stopwatch left out, as the worker counts it (SENSING_RESTED_MS)
+static bool syncing = false;   // catching up with the worker, until SENSING_SYNCED
+static int sync_laps = 0;      // laps of the worker in its SENSING_SYNC reply
+static bool recording = false; // the worker records the raw sensor samples (for tuning the detectors)
+static AppTimer* checkpoint_timer = NULL;
+static WorkoutState checkpoint_state; // last written to persistent memory
 
 // Accelerometer variables
-static char strokes_str[] = "           ";
 static int strokes_int = 0;
-static int root_sum_of_squares = 0;
-static int stroke_duration = 0;
-
-// Compass direction change detection variables
-static int degrees;            // compass degrees
-static int degreesAvg = -1;    // average of all degrees captured so far, set to -1 as a workout start flag
-static int degreesSum = 0;     // sum of all degrees captures during workout
-static int degreesCnt = 0;     // count of degrees captures during workout
-static int direction1 = 0;     // used to track direction change
-static int direction2 = 0;     // used to track direction change
+static int stroke_rate = 0;    // strokes per minute, from the worker
 
 // Workout counters
 static int lap = 0;            // workout lap counter
 static int distance = 0;       // workout distance
 static int strokes_of_lap = 0; // lap strokes
-static int swolf = 0;          // lap SWOLF
-static int swolf_avg = 0;      // average of current workout laps' SWOLF score
-static int swolf_avg_prev = 0; // average of latest workout laps' SWOLF score
-static int ssi = 0;            // SWOLF score percentage improvement (current vs last lap)
-
-// Low pass filter flag
-static int lowPassFilter = -1; // -1 disables the filter
+static int swolf = 0;          // lap SWOLF, the average and the others are in stats.c
+static int ssi = 0;            // SWOLF score percentage improvement (workout vs the recent ones)
 
 // Social interaction variables
 static int likes = 0;
-static char social[2000];
 
 // Workout ID
 static char workout_id_str[20] = "2016-01-01 00:00:00"; // The uniquie ID of the workout. Example: 20160726205015 (date format: YYYYMMDDHHMMSS)
@@ -115,94 +129,198 @@ static int pool = 0;
 // Function prototypes
 static void start_stopwatch();
 static void stop_stopwatch();
-static void start_accelerometer();
-static void stop_accelerometer();
-static void start_compass();
-static void stop_compass();
+static void start_sensing();
+static void stop_sensing();
 static void timer_handler(void*);
-static void start_accelerometer();
-static void accelerometer_handler(void*, uint32_t);
-static void compass_handler(CompassHeadingData);
+static void tick_handler(struct tm*, TimeUnits);
 static void send_data();
-static void update_distance();
-static void update_swolf_avg();
+static void mark_dirty(uint8_t fields);
 
 
 // Functions inplementation
 
+// Tick the stopwatch every 100ms while its hundredths are on screen, every second otherwise
+static void update_stopwatch_timer() {
+  bool fast = started && !resting && window_visible && STOPWATCH_HUNDREDTHS;
+  bool slow = started && !resting && !fast;
+
+  if (fast && update_timer == NULL) {
+    update_timer = app_timer_register(100, timer_handler, NULL);
+  } else if (!fast && update_timer != NULL) {
+    app_timer_cancel(update_timer);
+    update_timer = NULL;
+  }
+
+  if (slow && !ticking) {
+    tick_timer_service_subscribe(SECOND_UNIT, tick_handler);
+  } else if (!slow && ticking) {
+    tick_timer_service_unsubscribe();
+  }
+  ticking = slow;
+}
+
 static void start_stopwatch() {
   vibes_short_pulse();
-  // Set a timer handler (it calls the timer_handler function in 100ms)
-  update_timer = app_timer_register(100, timer_handler, NULL);
+  update_stopwatch_timer();
 }
 
 static void stop_stopwatch() {
   vibes_long_pulse();
-  app_timer_cancel(update_timer);
+  update_stopwatch_timer();
 }
 
-static void start_accelerometer() {
-  accel_service_set_sampling_rate( ACCEL_SAMPLING_RATE );
-  accel_data_service_subscribe( ACCEL_SAMPLES_PER_CALLBACK, (AccelDataHandler) accelerometer_handler );
+// The strokes and laps are counted by the background worker, which goes on when the app is closed
+static void send_sensing(uint8_t type) {
+  AppWorkerMessage message = { .data0 = strokes_int, .data1 = lap, .data2 = strokes_of_lap };
+  app_worker_send_message(type, &message);
 }
 
-static void stop_accelerometer() {
-  accel_data_service_unsubscribe();
+static void start_sensing() {
+  if (app_worker_is_running()) {
+    send_sensing(SENSING_START);
+  } else {
+    app_worker_launch(); // it asks to be started with SENSING_READY
+  }
 }
 
-static void start_compass() {
-  compass_service_subscribe(compass_handler);
-  compass_service_set_heading_filter(TRIG_MAX_ANGLE / 72); // 360 / 72 = 5 degrees (diff to trigger compass read)
+static void stop_sensing() {
+  send_sensing(SENSING_PAUSE);
 }
 
-static void stop_compass() {
-  compass_service_unsubscribe();
+static void send_record() {
+  AppWorkerMessage message = { .data0 = recording };
+  app_worker_send_message(SENSING_RECORD, &message);
 }
 
-static void update_strokes() {
-  snprintf(strokes_str, 20, "strokes:%d", strokes_int);
-  text_layer_set_text(text_layer_strokes, strokes_str);
+// Gather the workout state from the counters
+static void get_workout_state(WorkoutState *state) {
+  int64_t now = started && !resting ? clock_ms() : pause_time;
+
+  memset(state, 0, sizeof(WorkoutState));
+  state->version = WORKOUT_STATE_VERSION;
+  strncpy(state->workout_id, workout_id_str, sizeof(state->workout_id) - 1);
+  if (start_time != 0) {
+    state->elapsed_ms = now - start_time;
+    state->lap_elapsed_ms = now - lap_start_time;
+  }
+  state->strokes = strokes_int;
+  state->strokes_of_lap = strokes_of_lap;
+  state->laps = lap;
+  state->likes = likes;
+  state->pool = pool;
+  state->running_at = started ? now : 0;
+  stats_save(&state->stats);
+  state->resting = resting;
+  state->rested_ms = rested_ms;
 }
 
-static void update_laps() {
-  static char s_buffer_lap[10];
-  snprintf(s_buffer_lap, sizeof(s_buffer_lap), "laps:%d", lap);
-  text_layer_set_text(text_layer_laps, s_buffer_lap);
+// Whether the workout state changed since the last checkpoint. While running, the times only move
+// with the clock (elapsed_ms - running_at stays the same), the last checkpoint still gives them: only
+// the counters and the pauses count
+static bool checkpoint_changed(const WorkoutState *state) {
+  WorkoutState current = *state;
+  WorkoutState last = checkpoint_state;
+
+  if (current.running_at != 0 && last.running_at != 0) {
+    current.elapsed_ms -= current.running_at;
+    current.lap_elapsed_ms -= current.running_at;
+    last.elapsed_ms -= last.running_at;
+    last.lap_elapsed_ms -= last.running_at;
+    current.running_at = last.running_at = 0;
+  }
+  return memcmp(&current, &last, sizeof(current)) != 0;
 }
 
-static void update_distance() {
-  static char s_buffer_dist[10];
-  snprintf(s_buffer_dist, sizeof(s_buffer_dist), "%d", distance);
-  text_layer_set_text(text_layer_distance, s_buffer_dist);
+// Write the workout state to persistent memory, only when it changed since the last checkpoint
+static void checkpoint() {
+  WorkoutState state;
+
+  get_workout_state(&state);
+  if (checkpoint_changed(&state)) {
+    persist_write_data(WORKOUT_PKEY, &state, sizeof(state));
+    checkpoint_state = state;
+  }
 }
 
-static void update_swolf_avg() {
-  static char s_buffer_swolf_avg[10];
-  snprintf(s_buffer_swolf_avg, sizeof(s_buffer_swolf_avg), "SWOLF: %d", swolf_avg);
-  text_layer_set_text(text_layer_swolf_avg, s_buffer_swolf_avg);
+static void checkpoint_timer_handler(void *data) {
+  checkpoint();
+  checkpoint_timer = app_timer_register(CHECKPOINT_INTERVAL_MS, checkpoint_timer_handler, NULL);
 }
 
-static void select_click_handler(ClickRecognizerRef recognizer, void *context) {
-  show_score(ssi, &swolf_avg_prev);
+static void start_checkpoints() {
+  if (checkpoint_timer == NULL) {
+    checkpoint_timer = app_timer_register(CHECKPOINT_INTERVAL_MS, checkpoint_timer_handler, NULL);
+  }
 }
 
-static void deinit(void) {
+static void stop_checkpoints() {
+  if (checkpoint_timer != NULL) {
+    app_timer_cancel(checkpoint_timer);
+    checkpoint_timer = NULL;
+  }
+  checkpoint();
+}
 
-  // Store workout data to persistent memory on exit
+// Mark main screen metrics as changed, only those are re-formatted on the next redraw
+static void mark_dirty(uint8_t fields) {
+  metrics.elapsed_ms = elapsed_time;
+  metrics.strokes = strokes_int;
+  metrics.stroke_rate = stroke_rate;
+  metrics.laps = lap;
+  metrics.distance = distance;
+  metrics.swolf_avg = stat_mean(stats_get(STATS_SWOLF));
+  if (metrics_layer) {
+    metrics_layer_mark_dirty(metrics_layer, fields);
+  }
+}
 
-  persist_write_string(WORKOUT_ID_PKEY, workout_id_str);
+// Show a status message on the main screen
+static void show_msg(const char *msg) {
+  metrics.msg = msg;
+  mark_dirty(METRIC_MSG);
+}
 
-  struct StopwatchState state = (struct StopwatchState) {
-      .elapsed_time = elapsed_time,
-      .strokes = strokes_int,
-      .laps = lap,
-      .swolf_avg = swolf_avg,
-      .pool = pool
-  };
+// Gather the workout totals sent to the smartphone mobile companion application
+static void get_protocol_state(ProtocolState *state) {
+  WorkoutState workout;
+  get_workout_state(&workout);
+
+  state->fields[PROTOCOL_ELAPSED_MS] = workout.elapsed_ms;
+  state->fields[PROTOCOL_STROKES] = strokes_int;
+  state->fields[PROTOCOL_LAPS] = lap;
+  state->fields[PROTOCOL_DISTANCE] = distance;
+  state->fields[PROTOCOL_POOL] = pool;
+  const Stat *swolf_stat = stats_get(STATS_SWOLF);
+  const Stat *pace_stat = stats_get(STATS_PACE);
+  state->fields[PROTOCOL_SWOLF_AVG] = stat_mean(swolf_stat);
+  state->fields[PROTOCOL_SSI] = ssi;
+  state->fields[PROTOCOL_SWOLF_SD] = stat_stddev(swolf_stat);
+  state->fields[PROTOCOL_SWOLF_BEST] = swolf_stat->min;
+  state->fields[PROTOCOL_PACE_AVG] = stat_mean(pace_stat);
+  state->fields[PROTOCOL_PACE_BEST] = pace_stat->min;
+  state->fields[PROTOCOL_STROKES_AVG] = stat_mean(stats_get(STATS_STROKES));
+  state->fields[PROTOCOL_BEST_LAP] = stats_best_lap();
+  state->fields[PROTOCOL_LIKES] = likes;
+}
+
+// Queue the current totals, and a lap unless it is NULL, to the smartphone mobile companion
+// application: the message leaves from the outbox once the previous ones are delivered
+static void push_update(const LapRecord *lap) {
+  ProtocolState state;
+  get_protocol_state(&state);
+  outbox_push(workout_id_str, &state, lap);
+}
 
-  persist_write_data(STATE_PKEY, &state, sizeof(state));
-  persist_write_int(LIKES_PKEY, likes);
-  persist_write_string(SOCIAL_PKEY, social);
+static void select_click_handler(ClickRecognizerRef recognizer, void *context) {
+  show_score(ssi, rested_ms + (started && resting ? clock_ms() - pause_time : 0));
+}
+
+static void deinit(void) {
+
+  // Store workout data to persistent memory on exit
+  checkpoint();
+  feed_save(FEED_PKEY);
+  outbox_save();
   
   window_stack_pop_all(true);
 
@@ -212,21 +330,34 @@ static void deinit(void) {
 static void select_long_click_handler(ClickRecognizerRef recognizer, void *context) {
   if (!started) {
     
-    // Save SWOLF avg for future SSI calculation
-    if (swolf_avg > 0) {
-      swolf_avg_prev = swolf_avg;
-      persist_write_int(SWOLF_PREV_PKEY, swolf_avg_prev);
+    // Save the workout summary for the future SSI calculations
+    if (stats_get(STATS_SWOLF)->count > 0) {
+      WorkoutState workout;
+      get_workout_state(&workout);
+      HistoryRecord record = {
+        .date = time(NULL),
+        .elapsed_ms = workout.elapsed_ms,
+        .laps = lap,
+        .distance = distance,
+        .swolf_avg = stat_mean(stats_get(STATS_SWOLF)),
+        .pace_avg = stat_mean(stats_get(STATS_PACE)),
+      };
+      history_add(&record);
     }
 
-    //stop accelerometer & compass logging
-    stop_accelerometer();
-    stop_compass();
+    // Queue the final totals, the outbox keeps sending them and the laps left after the workout ended
+    push_update(NULL);
+
+    //stop the worker counting strokes & laps
+    app_worker_kill();
     stop_stopwatch();
     started = false;
-    pause_time = float_time_ms();
+    pause_time = clock_ms();
+    laplog_reset();
 
     // Initialize counters
     strokes_int = 0;
+    stroke_rate = 0;
     lap = 0;
     distance = 0;
     start_time = 0;
@@ -234,20 +365,16 @@ static void select_long_click_handler(ClickRecognizerRef recognizer, void *conte
     elapsed_time = 0;
     lap_time = 0;
     pause_time = 0;
+    rested_ms = 0;
     likes = 0;
     swolf = 0;
-    swolf_avg = 0;
+    ssi = 0;
     pool = 0;
+    stats_reset();
 
-    strcpy(social, SOCIAL_INIT_STR);
+    feed_reset();
 
-    update_elapsed_time(elapsed_time, elapsed_time_str);
-    text_layer_set_text(text_layer_elapsed_time, elapsed_time_str);
-
-    update_strokes();
-    update_laps();  
-    update_distance();
-    update_swolf_avg();
+    mark_dirty(METRIC_ALL);
 
     // Clear the date_time_str because this workout has been completed!
     memset(workout_id_str, 0, sizeof(workout_id_str));
@@ -260,64 +387,46 @@ static void select_long_click_handler(ClickRecognizerRef recognizer, void *conte
 static void up_click_handler(ClickRecognizerRef recognizer, void *context) {
   if (!started) {
     if (start_time == 0) {
-       start_time = float_time_ms();
+       start_time = clock_ms();
        lap_start_time = start_time;
      } else {
         if (pause_time != 0) {
-          interval = float_time_ms() - pause_time;
+          interval = clock_ms() - pause_time;
           start_time += interval;
           lap_start_time += interval;
         }
      }    
-    start_stopwatch();
-    start_accelerometer();
-    start_compass();
     started = true;
+    start_stopwatch();
+    start_sensing();
+    start_checkpoints();
   } else {
-    stop_accelerometer();
-    stop_compass();
-    stop_stopwatch();
     started = false;
-    pause_time = float_time_ms();
+    stop_sensing();
+    stop_stopwatch();
+    stroke_rate = 0;
+    mark_dirty(METRIC_RATE);
+    if (resting) {
+      resting = false; // already paused since the rest started
+    } else {
+      pause_time = clock_ms();
+    }
+    stop_checkpoints();
   }
 }
 
-// Send data over bluetooth to the smartphone mobile companion application
-static void send_data() {
-  text_layer_set_text(text_layer_msg, "Sending data...");
-
-  DictionaryIterator *iter;
-
-  // Create a message with collected workout data
-  app_message_outbox_begin(&iter);
-
-  const char * duration_str = "";
-  duration_str = elapsed_time_str;
-
-
-  // Add the data to the message
-
-  dict_write_cstring(iter, WORKOUT_ID_KEY, workout_id_str);
-  dict_write_cstring(iter, DURATION_KEY, duration_str);
-  dict_write_int(iter, STROKES_KEY, &strokes_int, sizeof(int), true);
-  dict_write_int(iter, LAPS_KEY, &lap, sizeof(int), true);
-  dict_write_int(iter, LIKES_KEY, &likes, sizeof(int), true);
-
-  // Send friends messages only if we received ones!
-  if (likes > 0) {
-    dict_write_cstring(iter, SOCIAL_KEY, social);
-  } else {
-    dict_write_cstring(iter, SOCIAL_KEY, "");
-  }
-
-  dict_write_int(iter, DISTANCE_KEY, &distance, sizeof(int), true);
-  dict_write_int(iter, POOL_KEY, &pool, sizeof(int), true);
-  dict_write_int(iter, SWOLF_KEY, &swolf_avg, sizeof(int), true);
-  dict_write_int(iter, SSI_KEY, &ssi, sizeof(int), true);
+// Write the workout data of a message, as queued in the outbox (see outbox.c)
+static void write_data(DictionaryIterator *iter, const OutboxWorkout *workout, const LapRecord *laps,
+                       int count) {
+  ProtocolState totals = workout->totals; // aligned copy of the packed queue entry
 
+  show_msg("Sending data...");
+  protocol_write(iter, &totals, workout->id, laps, count);
+}
 
-  // Transmit the message!
-  app_message_outbox_send();
+// Send data over bluetooth to the smartphone mobile companion application
+static void send_data() {
+  push_update(NULL);
 }
 
 static void down_click_handler(ClickRecognizerRef recognizer, void *context) {
@@ -325,9 +434,19 @@ static void down_click_handler(ClickRecognizerRef recognizer, void *context) {
   send_data();
 }
 
+// Long press the down button to record the raw sensor samples to DataLogging, or stop recording
+static void down_long_click_handler(ClickRecognizerRef recognizer, void *context) {
+  recording = !recording;
+  persist_write_bool(RECORD_PKEY, recording);
+  if (app_worker_is_running()) {
+    send_record();
+  }
+  show_msg(recording ? "Recording sensors" : "Recording stopped");
+}
+
 static void back_click_handler(ClickRecognizerRef recognizer, void *context) {
   // Display the social interraction screen
-  show_social(likes, social);
+  show_social(likes);
 }
 
 // Set the buttons click handler functions
@@ -336,140 +455,223 @@ static void click_config_provider(void *context) {
   window_single_click_subscribe(BUTTON_ID_UP, up_click_handler);
   window_single_click_subscribe(BUTTON_ID_SELECT, select_click_handler);
   window_single_click_subscribe(BUTTON_ID_DOWN, down_click_handler);
+  window_long_click_subscribe(BUTTON_ID_DOWN, 0, down_long_click_handler, NULL);
   window_single_click_subscribe(BUTTON_ID_BACK, back_click_handler);
 }
 
-// Set a repeated timer handler of 100ms interval to log some periods
+// Update the stopwatch periods
+static void stopwatch_tick() {
+  int64_t now = clock_ms();
+  elapsed_time = now - start_time;
+  lap_time = now - lap_start_time;
+  mark_dirty(METRIC_TIME);
+}
+
+// Stopwatch timer handler of 100ms interval, while the hundredths are on screen
 static void timer_handler(void* data) {
-  if (started) {
-    double now = float_time_ms();
-    elapsed_time = now - start_time;
-    lap_time = now - lap_start_time;
-    update_timer = app_timer_register(100, timer_handler, NULL); // Recursively calls itself after every 100ms
+  update_timer = NULL;
+  if (started && !resting) {
+    stopwatch_tick();
+    update_stopwatch_timer(); // Calls itself again after 100ms
   }
-  update_elapsed_time(elapsed_time, elapsed_time_str);
-  text_layer_set_text(text_layer_elapsed_time, elapsed_time_str);
 }
 
-// Implementation of swimming strokes detection / counting algorithm
-static void accelerometer_handler(void * data, uint32_t num_samples)
-{
-  // AppMessageResult result;
-  AccelData * vector = (AccelData*) data;
+// Stopwatch tick handler of 1sec interval, otherwise
+static void tick_handler(struct tm *tick_time, TimeUnits units_changed) {
+  if (started && !resting) {
+    stopwatch_tick();
+  }
+}
 
-  // counting strokes --> start  
-  //
-  // Determine if the sample occured during vibration
-  bool did_vibrate = vector->did_vibrate;
+// SWOLF score improvement of the workout average over the baseline of the recent workouts, in %
+// (rounded): those of the last 7 days, else of the last 30 days, else the last workout
+static void update_ssi() {
+  int swolf_avg = stat_mean(stats_get(STATS_SWOLF));
+  int baseline;
 
-  // if no, then do the math
-  if (!did_vibrate) {
-    
-    // Calculate the acceleration of the swimmer's wrist
-    root_sum_of_squares = mySqrtf(vector->x*vector->x + vector->y*vector->y + vector->z*vector->z);
-    
-    // Check if this acceleration if above a threshold
-    if (abs(1000 - root_sum_of_squares) > ACCEL_THRESHOLD) {
-      // and if yes, log for how long!
-      stroke_duration++;
-    }
+  history_update(time(NULL));
+  baseline = history_swolf_avg(HISTORY_WEEK);
+  if (baseline == 0) {
+    baseline = history_swolf_avg(HISTORY_MONTH);
+  }
+  if (baseline == 0 && history_count() > 0) {
+    baseline = history_get(history_count() - 1)->swolf_avg;
+  }
 
-    // OK, we have a new swimming stroke here! Log it!
-    if (stroke_duration == ACCEL_DURATION) {
-      strokes_int += 2; // increase total strokes by 2(hands)
-      update_strokes();
-      stroke_duration = 0;
-      strokes_of_lap += 2; // increase strokes of current lap to calculate the SWOLF score of the lap
-      // APP_LOG(APP_LOG_LEVEL_INFO, ">>stroke_duration: %d", stroke_duration);
+  ssi = 0;
+  if (swolf_avg > 0 && baseline > 0) {
+    ssi = 100 - (swolf_avg * 100 + baseline / 2) / baseline;
+    if (ssi < 0) {
+      ssi = 0;
     }
+  }
+}
 
+// Count a new lap, that ended when the swimmer turned at the wall
+static void count_lap(int64_t turn_time, StrokeType stroke_type) {
+  if (turn_time < lap_start_time) {
+    turn_time = lap_start_time; // the turn started before a pause
   }
-  //
-  // counting strokes --> end
-  
+  lap_time = turn_time - lap_start_time;
+
+  lap++;
+  distance = lap * pool;
+  // SWOLF: the strokes plus the seconds of the lap (rounded)
+  swolf = strokes_of_lap + (int)((lap_time + 500) / 1000);
+  if (pool == 50) {
+    // Dividing SWOLF score by 2, for accurate SSI calculations
+    // Always doing the math on a 25m pool SWOLF score basis so as to be able to
+    // correctly calculate the total SWOLF score average of the swimmer's workouts
+    // and get accurate SSI metrics!
+    swolf = (int)(swolf / 2);
+  }
+
+  stats_add_lap(lap, lap_time, strokes_of_lap, swolf, pool);
+  update_ssi();
+
+  laplog_add(lap, lap_start_time - start_time, lap_time, strokes_of_lap, swolf, stroke_type);
+
+  strokes_of_lap = 0;
+  lap_start_time = turn_time;
+  lap_time = clock_ms() - lap_start_time;
+
+  checkpoint();
+
+  // Send data to the android compation app (and from there to the web service), to track the workout in real time!
+  push_update(laplog_last());
+
+  mark_dirty(METRIC_LAPS | METRIC_DISTANCE | METRIC_SWOLF);
 }
 
-// Lap counting detection (direction change) algorithm implementation
-static void compass_handler(CompassHeadingData data) {
+// Counters from the background worker (see worker_src/ubiswim_worker.c)
+// Laps counted while the app was closed, and not replayed
+static void catch_up_laps(int laps) {
+  if (laps > lap) {
+    lap = laps;
+    distance = lap * pool;
+    mark_dirty(METRIC_LAPS | METRIC_DISTANCE);
+  }
+}
 
-    int degreesAvgDiff;
-    
-    degrees = TRIGANGLE_TO_DEG((int)data.true_heading);
-    
-    if (lowPassFilter == -1) {
-      lowPassFilter = degrees;
-    } else {;
-      lowPassFilter = lowPassFilter + (COMPASS_ALPHA * (degrees - lowPassFilter) + 0.5); // +0.5 to round up!
+// Take the run/rest state of the worker after a sync, it went on while the app was closed. When
+// started, the stopwatch ran up to now from the last checkpoint, through the rests the app did not see.
+static void adopt_worker_state(SensingState state, uint32_t worker_rested_ms) {
+  int64_t now = clock_ms();
+
+  if (started) {
+    interval = worker_rested_ms - rested_ms;
+    start_time += interval;
+    lap_start_time += interval;
+    if (state == SENSING_RESTING) {
+      resting = true;
+      pause_time = now; // the rest so far is off the stopwatch already
+    } else if (state == SENSING_PAUSED) {
+      started = false;
+      pause_time = now;
+      stop_checkpoints();
     }
-    
-    degreesCnt++;
-    if (degreesAvg == -1) {
-      degreesSum = degrees;
-      degreesAvg = degrees;
+  } else if (state != SENSING_PAUSED) {
+    // Paused by the checkpoint, which was taken before a crash or did not tell the rests (version 3)
+    started = true;
+    if (state == SENSING_RESTING) {
+      resting = true; // from the pause on
     } else {
-      degreesSum = degreesSum + degrees;
-      degreesAvg = ( (degreesSum) / degreesCnt ) + 0.5; // +0.5 to round up (degreesAvg gets the int value!)
+      interval = now - pause_time;
+      start_time += interval;
+      lap_start_time += interval;
+      pause_time = 0;
     }
-    
-    degreesAvg = degreesAvg - COMPASS_ALPHA * degreesAvg; // Apply low pass filter to avg (minus used here to lower the avg graph!)
+    start_checkpoints();
+  }
+  rested_ms = worker_rested_ms;
 
-    degreesAvgDiff = degreesAvg - lowPassFilter; // Calc diff to check current graph status
+  if (resting) {
+    show_msg("Resting...");
+  }
+  elapsed_time = (started && !resting ? now : pause_time) - start_time;
+  update_stopwatch_timer();
+  mark_dirty(METRIC_ALL);
+  checkpoint();
+}
 
-    if (degreesAvgDiff >= 0) { // positive values: avg graph below lowpass graph
-      direction1++;
-      direction2 = 0;
-    } else {                   // negative values: avg graph above lowpass graph
-      direction2++;
-      direction1 = 0;
-    }
-    
-    if (direction1 == COMPASS_DURATION || direction2 == COMPASS_DURATION) {
-      lap++;
-      distance = lap * pool;
-      swolf = pool + (int)lap_time % 60;
-      if (pool == 50) {
-        // Dividing SWOLF score by 2, for accurate SSI calculations
-        // Always doing the math on a 25m pool SWOLF score basis so as to be able to
-        // correctly calculate the total SWOLF score average of the swimmer's workouts
-        // and get accurate SSI metrics!
-        swolf = (int)(swolf / 2);
+static void worker_message_handler(uint16_t type, AppWorkerMessage *data) {
+  switch (type) {
+    case SENSING_READY:
+      syncing = false; // a new worker, nothing to catch up with
+      rested_ms = 0;
+      if (started) {
+        send_sensing(SENSING_START);
       }
-      
-      if (lap == 1) {
-        swolf_avg = 0;
-      } else {
-        if (lap == 2) {
-          swolf_avg = swolf;
-        } else {
-          swolf_avg = (int)((swolf_avg + swolf) / 2);  
-        }
+      if (recording) {
+        send_record();
       }
-
-      if (lap > 1 && swolf_avg_prev > 0) {
-        double swolf_avg_d = swolf_avg;
-        double swolf_avg_prev_d = swolf_avg_prev;
-        ssi = 100 - (((swolf_avg_d / swolf_avg_prev_d) * 100) + 0.5); // 0.5 to round up
-        if (ssi < 0) {
-          ssi = 0;
+      break;
+    case SENSING_LAP:
+      if (syncing) {
+        break; // sent before the sync, its replay has it
+      }
+      if (data->data0 > lap + 1) {
+        lap = data->data0 - 1; // laps counted while the app was closed
+      }
+      strokes_of_lap = SENSING_LAP_STROKES(data->data2);
+      count_lap(clock_ms() - data->data1, SENSING_LAP_TYPE(data->data2));
+      break;
+    case SENSING_LAP_LOGGED:
+      // A lap counted while the app was closed, it follows the lap in progress when the app closed
+      if (data->data0 > lap) {
+        if (data->data0 > lap + 1) {
+          lap = data->data0 - 1; // older than the worker's log, only in the counts
         }
+        strokes_of_lap = SENSING_LAP_STROKES(data->data2);
+        count_lap(lap_start_time + data->data1 * 100, SENSING_LAP_TYPE(data->data2));
       }
-
-      // APP_LOG(APP_LOG_LEVEL_INFO, ">>lap_time:%d swolf:%d swolf_avg:%d swolf_avg_prev:%d ssi:%d", (int)lap_time % 60, swolf, swolf_avg, swolf_avg_prev, ssi);        
-
-      strokes_of_lap = 0;
-      lap_time = 0;
-      lap_start_time = float_time_ms();
-
-      // Send data to the android compation app (and from there to the web service), to track the workout in real time!
-      send_data();
-    }
-    
-    update_laps();
-    update_distance();
-    update_swolf_avg();
-
-    // APP_LOG(APP_LOG_LEVEL_INFO, "d:%d c:%d s:%d l:%d a:%d df:%d d1:%d d2:%d lp:%d", degrees, degreesCnt, degreesSum, lowPassFilter, degreesAvg, degreesAvgDiff, direction1, direction2, lap); 
-
+      break;
+    case SENSING_REST:
+      // Pause the stopwatch from the start of the rest. While syncing, the SENSING_SYNCED reply tells
+      // the rests
+      if (started && !resting && !syncing) {
+        resting = true;
+        pause_time = clock_ms() - data->data0;
+        elapsed_time = pause_time - start_time;
+        lap_time = pause_time - lap_start_time;
+        update_stopwatch_timer();
+        show_msg("Resting...");
+        stroke_rate = 0;
+        mark_dirty(METRIC_TIME | METRIC_RATE);
+        checkpoint();
+      }
+      break;
+    case SENSING_RESUME:
+      if (resting && !syncing) {
+        resting = false;
+        rested_ms = SENSING_RESTED_MS(data->data1, data->data2);
+        interval = clock_ms() - pause_time;
+        start_time += interval;
+        lap_start_time += interval;
+        update_stopwatch_timer();
+        show_msg("Back to swimming!");
+      }
+      break;
+    case SENSING_TEMPO:
+      stroke_rate = data->data0;
+      mark_dirty(METRIC_RATE);
+      break;
+    case SENSING_COUNTS:
+      strokes_int = data->data0;
+      if (syncing) {
+        sync_laps = data->data1; // counted once the replay is done
+      } else {
+        catch_up_laps(data->data1);
+      }
+      strokes_of_lap = data->data2;
+      mark_dirty(METRIC_STROKES);
+      break;
+    case SENSING_SYNCED:
+      syncing = false;
+      catch_up_laps(sync_laps); // older than the worker's log, only in the counts
+      adopt_worker_state(data->data0, SENSING_RESTED_MS(data->data1, data->data2));
+      break;
+  }
 }
 
 // Create main app interface
@@ -478,75 +680,42 @@ static void window_load(Window *window) {
   Layer *window_layer = window_get_root_layer(window);
   GRect bounds = layer_get_bounds(window_layer);
 
-  text_layer_app_name = text_layer_create(GRect(0, 0, bounds.size.w, 16));
-  text_layer_set_text(text_layer_app_name, "UbiSwim.org");
-  text_layer_set_text_alignment(text_layer_app_name, GTextAlignmentCenter);
-  layer_add_child(window_layer, text_layer_get_layer(text_layer_app_name));
-
-  text_layer_elapsed_time = text_layer_create(GRect(0, 20, bounds.size.w, 28));
-  text_layer_set_font(text_layer_elapsed_time, fonts_get_system_font(FONT_KEY_GOTHIC_28_BOLD));
-  text_layer_set_text(text_layer_elapsed_time, elapsed_time_str);
-  text_layer_set_text_alignment(text_layer_elapsed_time, GTextAlignmentCenter);
-  layer_add_child(window_layer, text_layer_get_layer(text_layer_elapsed_time));
-
-  text_layer_distance = text_layer_create(GRect(0, 50, 120, 42));
-  text_layer_set_font(text_layer_distance, fonts_get_system_font(FONT_KEY_BITHAM_42_BOLD)); 
-  text_layer_set_text(text_layer_distance, "0");
-  text_layer_set_text_alignment(text_layer_distance, GTextAlignmentRight);
-  layer_add_child(window_layer, text_layer_get_layer(text_layer_distance));
-
-  text_layer_m = text_layer_create(GRect(120, 70, 140, 18));
-  text_layer_set_font(text_layer_m, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD)); 
-  text_layer_set_text(text_layer_m, "m");
-  text_layer_set_text_alignment(text_layer_m, GTextAlignmentLeft);
-  layer_add_child(window_layer, text_layer_get_layer(text_layer_m));
-
-  text_layer_swolf_avg = text_layer_create(GRect(0, 95, 120, 28));
-  text_layer_set_font(text_layer_swolf_avg, fonts_get_system_font(FONT_KEY_GOTHIC_28_BOLD));
-  text_layer_set_text(text_layer_swolf_avg, swolf_avg_str);
-  text_layer_set_text_alignment(text_layer_swolf_avg, GTextAlignmentRight);
-  layer_add_child(window_layer, text_layer_get_layer(text_layer_swolf_avg));
-
-  text_layer_strokes = text_layer_create(GRect(8, 135, 90, 16));
-  // text_layer_set_font(text_layer_strokes, fonts_get_system_font(FONT_KEY_GOTHIC_28_BOLD)); 
-  text_layer_set_text_alignment(text_layer_strokes, GTextAlignmentLeft);
-  layer_add_child(window_layer, text_layer_get_layer(text_layer_strokes));
-
-  text_layer_laps = text_layer_create(GRect(90, 135, 50, 16));
-  // text_layer_set_font(text_layer_laps, fonts_get_system_font(FONT_KEY_BITHAM_42_BOLD)); 
-  text_layer_set_text_alignment(text_layer_laps, GTextAlignmentLeft);
-  layer_add_child(window_layer, text_layer_get_layer(text_layer_laps));
-
-  text_layer_msg = text_layer_create(GRect(0, 150, bounds.size.w, 16));
-  text_layer_set_text(text_layer_msg, "U:Start M:Score D:Send");
-  text_layer_set_text_alignment(text_layer_msg, GTextAlignmentCenter);
-  layer_add_child(window_layer, text_layer_get_layer(text_layer_msg));
-
-  // Update counter values on screen
-  update_strokes();
-  update_laps();
-  update_distance();
-  update_swolf_avg();
+  // All the counters are drawn by a single layer
+  metrics_layer = metrics_layer_create(bounds, &metrics);
+  layer_add_child(window_layer, metrics_layer);
+  mark_dirty(METRIC_ALL);
+
+}
 
+// Tick faster again when the window appears (what changed meanwhile is redrawn by the system)
+static void window_appear(Window *window) {
+  window_visible = true;
+  update_stopwatch_timer();
+}
+
+// Tick slower while another window covers the main screen
+static void window_disappear(Window *window) {
+  window_visible = false;
+  update_stopwatch_timer();
 }
 
 // Destroy layers to free up memory
 static void window_unload(Window *window) {
-  text_layer_destroy(text_layer_app_name);
-  text_layer_destroy(text_layer_elapsed_time);
-  text_layer_destroy(text_layer_strokes);
-  text_layer_destroy(text_layer_laps);
-  text_layer_destroy(text_layer_msg);
+  metrics_layer_destroy(metrics_layer);
+  metrics_layer = NULL;
 }
 
 static void outbox_sent_handler(DictionaryIterator *iter, void *context) {
   // Succesful transmission
-  text_layer_set_text(text_layer_msg, "Data succesfully sent!");
+  show_msg("Data succesfully sent!");
+  protocol_acked();
+  outbox_sent();
 }
 
 static void outbox_failed_handler(DictionaryIterator *iter, AppMessageResult reason, void *context) {
-  // Failed transmission
-  text_layer_set_text(text_layer_msg, "Send failed!");
+  // Failed transmission, it is retried later
+  show_msg("Send failed!");
+  outbox_failed(reason);
   // APP_LOG(APP_LOG_LEVEL_ERROR, "Fail reason: %d", (int)reason);
 }
 
@@ -554,43 +723,27 @@ static void outbox_failed_handler(DictionaryIterator *iter, AppMessageResult rea
 static void inbox_received_callback(DictionaryIterator *iter, void *context) {
   // A new message has been successfully received
 
-  // Read the friends name string
-  int AppKeyFriendName = 0;
-  Tuple *friendName_tuple = dict_find(iter, AppKeyFriendName);
-  char *friendName = malloc(10 * sizeof(char));  
-  if (friendName_tuple) {
-    // This value was stored as JS String, which is stored here as a char string
-     strcpy(friendName, friendName_tuple->value->cstring);
+  // The phone app restarted, or missed a message: the deltas have no base there anymore
+  if (dict_find(iter, PROTOCOL_RESYNC_KEY)) {
+    protocol_reset();
+    outbox_resync();
   }
+
+  // Read the friends name string
+  Tuple *friendName_tuple = dict_find(iter, PROTOCOL_FRIEND_NAME_KEY);
  
   // Read the friends message
-  int AppKeyFriendMessage = 1;
-  Tuple *friendMessage_tuple = dict_find(iter, AppKeyFriendMessage);
-  char *friendMessage = malloc(20 * sizeof(char));
-  if (friendMessage_tuple) {
-    // This value was stored as JS String, which is stored here as a char string
-    strcpy(friendMessage, friendMessage_tuple->value->cstring);
-  }
-
-  // Create a temporary social_str
-  char *social_str = malloc(2000 * sizeof(char));
-  strcpy(social_str, "[");
-  strcat(social_str, friendName);
-  strcat(social_str, "]: ");
-  strcat(social_str, friendMessage);
-  strcat(social_str, "  ");
-  
-  if (likes == 0) {
-    strcpy(social, social_str);  // Initialize
-  } else {
-    strcat(social, social_str);  // Concatenate
+  Tuple *friendMessage_tuple = dict_find(iter, PROTOCOL_FRIEND_MESSAGE_KEY);
+  if (!friendName_tuple && !friendMessage_tuple) {
+    return;
   }
-  
+
+  // Append it to the feed (this value was stored as JS String, which is stored here as a char string)
+  feed_add(friendName_tuple ? friendName_tuple->value->cstring : "",
+           friendMessage_tuple ? friendMessage_tuple->value->cstring : "",
+           time(NULL));
+  social_feed_changed();
   likes++;
-  
-  free(friendName);
-  free(friendMessage);
-  free(social_str);
 
   // Vibrate to inform the swimmer for the received "like" while working out
   vibes_double_pulse();
@@ -603,18 +756,19 @@ static void inbox_dropped_callback(AppMessageResult reason, void *context) {
 }
 
 static void init_main_ui() {
-  update_elapsed_time(elapsed_time, elapsed_time_str);
-
   window = window_create();
   window_set_click_config_provider(window, click_config_provider);
   window_set_window_handlers(window, (WindowHandlers) {
     .load = window_load,
+    .appear = window_appear,
+    .disappear = window_disappear,
     .unload = window_unload,
   });
   const bool animated = false;
   window_stack_push(window, animated);
 
   // Register sent and failed appmessage handlers
+  app_worker_message_subscribe(worker_message_handler);
   app_message_register_outbox_sent(outbox_sent_handler);
   app_message_register_outbox_failed(outbox_failed_handler);
 
@@ -622,65 +776,140 @@ static void init_main_ui() {
   app_message_register_inbox_received(inbox_received_callback);
   app_message_register_inbox_dropped(inbox_dropped_callback);
 
-  // Open appmessage
-  app_message_open(app_message_inbox_size_maximum(), app_message_outbox_size_maximum());
+  // Open appmessage, with buffers sized for our messages rather than the largest ones possible
+  uint32_t inbox_size = PROTOCOL_INBOX_SIZE;
+  uint32_t outbox_size = PROTOCOL_OUTBOX_SIZE;
+  if (inbox_size > app_message_inbox_size_maximum()) {
+    inbox_size = app_message_inbox_size_maximum();
+  }
+  if (outbox_size > app_message_outbox_size_maximum()) {
+    outbox_size = app_message_outbox_size_maximum();
+  }
+  app_message_open(inbox_size, outbox_size);
+  APP_LOG(APP_LOG_LEVEL_INFO, "AppMessage inbox %d + outbox %d bytes, %d bytes reclaimed, %d bytes free",
+          (int)inbox_size, (int)outbox_size,
+          (int)(app_message_inbox_size_maximum() + app_message_outbox_size_maximum() - inbox_size - outbox_size),
+          (int)heap_bytes_free());
+
+  // Send the laps left over from the last run
+  outbox_init(OUTBOX_PKEY, write_data);
 }
 
-// App initialization
-static void init(void) {
-
-  // Read workout data from persistent memory
+// Read the workout state from persistent memory, migrating the one of an older version: it resumes
+// paused, with the stats of the laps to come only (the old SWOLF average used another formula)
+static bool read_workout_state(WorkoutState *state) {
+  WorkoutStateV1 old;
+  StopwatchState stopwatch;
+  int size = persist_read_data(WORKOUT_PKEY, state, sizeof(WorkoutState));
 
-  if (persist_exists(WORKOUT_ID_PKEY)) {
-    persist_read_string(WORKOUT_ID_PKEY, workout_id_str, sizeof(workout_id_str));
-    if (strlen(workout_id_str) != 19) {
-      // It gets in here when a workout has been completed previously and an empty string has been saved into the WORKOUT_ID_PKEY,
-      // so a new date & time string should be created for the new workout!
-      createDateTimeStr(workout_id_str);  
-    }
+  if (size == sizeof(WorkoutState) && state->version == WORKOUT_STATE_VERSION) {
+    return true;
+  }
+  if (size == (int)WORKOUT_STATE_V3_SIZE && state->version == 3) {
+    // A rest was saved as a pause, the worker sync tells whether it goes on
+    memset((uint8_t *)state + WORKOUT_STATE_V3_SIZE, 0, sizeof(WorkoutState) - WORKOUT_STATE_V3_SIZE);
+  } else if (size >= (int)sizeof(old) && (state->version == 1 || state->version == 2)) {
+    memcpy(&old, state, sizeof(old));
+    memset(state, 0, sizeof(WorkoutState));
+    memcpy(state->workout_id, old.workout_id, sizeof(state->workout_id));
+    state->workout_id[sizeof(state->workout_id) - 1] = '\0';
+    state->elapsed_ms = old.elapsed_ms;
+    state->lap_elapsed_ms = old.lap_elapsed_ms;
+    state->strokes = old.strokes;
+    state->strokes_of_lap = old.strokes_of_lap;
+    state->laps = old.laps;
+    state->likes = old.likes;
+    state->pool = old.pool;
+  } else if (persist_read_data(STATE_PKEY, &stopwatch, sizeof(stopwatch)) == sizeof(stopwatch)) {
+    memset(state, 0, sizeof(WorkoutState));
+    persist_read_string(WORKOUT_ID_PKEY, state->workout_id, sizeof(state->workout_id));
+    state->elapsed_ms = stopwatch.elapsed_time;
+    state->lap_elapsed_ms = 0;  // the lap time was not kept
+    state->strokes = stopwatch.strokes;
+    state->laps = stopwatch.laps;
+    state->likes = persist_exists(LIKES_PKEY) ? persist_read_int(LIKES_PKEY) : 0;
+    state->pool = stopwatch.pool;
   } else {
-    createDateTimeStr(workout_id_str);
+    return false;
   }
 
-  struct StopwatchState state;
-  if (persist_read_data(STATE_PKEY, &state, sizeof(state)) != E_DOES_NOT_EXIST) {
-    elapsed_time = state.elapsed_time;
+  state->version = WORKOUT_STATE_VERSION;
+  persist_write_data(WORKOUT_PKEY, state, sizeof(WorkoutState));
+  return true;
+}
+
+// App initialization
+static void init(void) {
+
+  // Read the workout in progress from persistent memory
+  WorkoutState state;
+  if (read_workout_state(&state) && strlen(state.workout_id) == 19) {
+    // Resume it, still running if the worker kept counting while the app was closed, otherwise paused
+    checkpoint_state = state;
+    strncpy(workout_id_str, state.workout_id, sizeof(workout_id_str));
+    elapsed_time = state.elapsed_ms;
     strokes_int = state.strokes;
+    strokes_of_lap = state.strokes_of_lap;
     lap = state.laps;
-    swolf_avg = state.swolf_avg;
+    stats_load(&state.stats);
+    likes = state.likes;
     pool = state.pool;
-    start_time = float_time_ms() - elapsed_time;
-    pause_time = float_time_ms() ;
+    rested_ms = state.rested_ms;
+    pause_time = clock_ms();
+    if (state.running_at != 0 && app_worker_is_running()) {
+      // Run the stopwatch up to now, the worker sync takes off the rests and tells if it rests now
+      elapsed_time += pause_time - state.running_at;
+      state.lap_elapsed_ms += pause_time - state.running_at;
+      started = true;
+    }
+    start_time = pause_time - elapsed_time;
+    lap_start_time = pause_time - state.lap_elapsed_ms;
     interval = elapsed_time;
+    if (started) {
+      pause_time = 0;
+    }
   } else {
-    elapsed_time = 0;
-    strokes_int = 0;
-    lap = 0;
+    // The last workout has been completed, so a new date & time string is created for the new one
+    createDateTimeStr(workout_id_str);
   }
 
-  if (persist_exists(LIKES_PKEY)) {
-    likes = persist_read_int(LIKES_PKEY);
-  } else {
-    likes = 0;
+  // The workout used to be kept in several keys, migrated above
+  if (persist_exists(STATE_PKEY)) {
+    persist_delete(WORKOUT_ID_PKEY);
+    persist_delete(STATE_PKEY);
+    persist_delete(LIKES_PKEY);
   }
 
+  // The messages used to be kept as a single string, which is dropped
   if (persist_exists(SOCIAL_PKEY)) {
-    persist_read_string(SOCIAL_PKEY, social, sizeof(social));
-  } else {
-    strcpy(social, SOCIAL_INIT_STR);
+    persist_delete(SOCIAL_PKEY);
   }
+  feed_load(FEED_PKEY);
 
+  recording = persist_read_bool(RECORD_PKEY);
+
+  // The SWOLF average of the last workout used to be kept alone, with the old SWOLF formula: it is
+  // dropped, not comparable with the new one
+  history_load(HISTORY_PKEY);
   if (persist_exists(SWOLF_PREV_PKEY)) {
-    swolf_avg_prev = persist_read_int(SWOLF_PREV_PKEY);
-    // APP_LOG(APP_LOG_LEVEL_INFO, ">>persist_read(SWOLF_PREV_PKEY): %d", swolf_avg_prev);  
-  } else {
-    swolf_avg_prev = 0;
+    persist_delete(SWOLF_PREV_PKEY);
   }
+  update_ssi();
 
   distance = pool * lap;
 
   init_main_ui();
 
+  // The workout went on in the worker, catch up with its counters and its run/rest state
+  if (started) {
+    update_stopwatch_timer();
+    start_checkpoints();
+  }
+  if (app_worker_is_running()) {
+    syncing = true;
+    send_sensing(SENSING_SYNC);
+  }
+
   // It's a new workout
   if (pool == 0) {
     // so display the pool screen to select the pool size
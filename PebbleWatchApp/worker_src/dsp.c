@@ -0,0 +1,33 @@
+// sensor DSP kernels code
+//
+// The multiply-add loops of the autocorrelations (see stroketype.c and tempo.c), where the detectors
+// spend most of their time.
+
+#include <pebble_worker.h>
+#include <dsp.h>
+
+// Sum of a[i] * b[i] for i < n
+int64_t dsp_dot16(const int16_t *a, const int16_t *b, int n) {
+  int64_t sum = 0;
+  int i = 0;
+
+#if DSP_SIMD
+  // Two products a cycle: load pairs of samples as words (unaligned loads are fine on the M4)
+  for (; i + 1 < n; i += 2) {
+    uint32_t pair_a, pair_b;
+    memcpy(&pair_a, a + i, sizeof(pair_a));
+    memcpy(&pair_b, b + i, sizeof(pair_b));
+    __asm__("smlald %Q0, %R0, %1, %2" : "+r"(sum) : "r"(pair_a), "r"(pair_b));
+  }
+#else
+  // The 32 bit partial sums of a few products cannot overflow (|a|, |b| < 2^14), the M3 then only
+  // does a 64 bit add every 4 products
+  for (; i + 3 < n; i += 4) {
+    sum += a[i] * b[i] + a[i + 1] * b[i + 1] + a[i + 2] * b[i + 2] + a[i + 3] * b[i + 3];
+  }
+#endif
+  for (; i < n; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
\ No newline at end of file
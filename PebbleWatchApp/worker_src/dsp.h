@@ -0,0 +1,28 @@
+// sensor DSP kernels functions prototypes
+//
+// The kernels are picked at compile time for the platform: basalt has a Cortex-M4, whose DSP
+// extension multiplies and adds two packed 16 bit values in one instruction (SMLAD, SMLALD). The
+// aplite Cortex-M3 lacks it, and so does the host, they use the portable C. The M4 path is taken
+// when the compiler targets it (__ARM_FEATURE_DSP, see wscript).
+
+#if defined(PBL_PLATFORM_BASALT) && defined(__ARM_FEATURE_DSP)
+#define DSP_SIMD 1
+#else
+#define DSP_SIMD 0
+#endif
+
+// Squared magnitude of a sample (mg²). x and y are next to each other in AccelData, one packed
+// dual multiply-add squares and adds them.
+static inline int32_t dsp_magnitude_sq(const AccelData *vector) {
+#if DSP_SIMD
+  uint32_t xy;
+  int32_t sum_of_squares;
+  memcpy(&xy, &vector->x, sizeof(xy));
+  __asm__("smlad %0, %1, %1, %2" : "=r"(sum_of_squares) : "r"(xy), "r"(vector->z * vector->z));
+  return sum_of_squares;
+#else
+  return vector->x*vector->x + vector->y*vector->y + vector->z*vector->z;
+#endif
+}
+
+int64_t dsp_dot16(const int16_t *a, const int16_t *b, int n);
\ No newline at end of file
@@ -0,0 +1,146 @@
+// laps detection code
+
+#include <pebble_worker.h>
+#include <common.h>
+#include <laps.h>
+
+// Headings are kept as unit vectors (cos, sin) scaled to +/-4096, so the circular mean is the sum
+// of the vectors and works across the 0/360 wrap. Sums of COMPASS_WINDOW vectors fit an int32 and
+// the squared comparisons below fit an int64.
+#define UNIT_SHIFT 4 // TRIG_MAX_RATIO >> 4 = 4095
+
+typedef struct {
+  int16_t x;
+  int16_t y;
+} Heading;
+
+// Swimming direction: ring buffer of the latest headings and their running sum
+static Heading window[COMPASS_WINDOW];
+static int window_head = 0;  // oldest heading, next one to be replaced
+static int window_cnt = 0;
+static int32_t sum_x = 0;
+static int32_t sum_y = 0;
+
+// Headings (and their time) that turned away from the swimming direction, the first one is the turn instant
+static Heading turn[COMPASS_DURATION];
+static int64_t turn_times[COMPASS_DURATION];
+static int turn_cnt = 0;
+
+// Time of the latest push-off off the wall (accelerometer), -1 if none
+static int64_t push_off_time = -1;
+
+// cos(COMPASS_TURN_ANGLE) in the unit vector scale
+static int32_t turn_cos = 0;
+
+// Start detecting from scratch (new workout)
+void laps_reset() {
+  window_head = 0;
+  window_cnt = 0;
+  sum_x = 0;
+  sum_y = 0;
+  turn_cnt = 0;
+  push_off_time = -1;
+}
+
+// Add a heading to the swimming direction, replacing the oldest one when the window is full. O(1)
+static void window_push(Heading h) {
+  if (window_cnt == COMPASS_WINDOW) {
+    sum_x -= window[window_head].x;
+    sum_y -= window[window_head].y;
+  } else {
+    window_cnt++;
+  }
+  window[window_head] = h;
+  window_head = (window_head + 1) % COMPASS_WINDOW;
+  sum_x += h.x;
+  sum_y += h.y;
+}
+
+// Is the heading more than COMPASS_TURN_ANGLE away from the swimming direction?
+// dot = |sum| * |h| * cos(angle), so angle > COMPASS_TURN_ANGLE <=> dot < |sum| * turn_cos
+static bool is_turned(Heading h) {
+  int64_t dot = (int64_t)sum_x * h.x + (int64_t)sum_y * h.y;
+  int64_t sum_sq = (int64_t)sum_x * sum_x + (int64_t)sum_y * sum_y;
+
+  if (dot < 0) {
+    return true;
+  }
+  return dot * dot < sum_sq * turn_cos * turn_cos;
+}
+
+// Is the swimming direction steady? (the mean vector is at least half a unit long)
+static bool is_steady() {
+  int64_t sum_sq = (int64_t)sum_x * sum_x + (int64_t)sum_y * sum_y;
+  int64_t half = (int64_t)window_cnt * (TRIG_MAX_RATIO >> UNIT_SHIFT) / 2;
+
+  return window_cnt >= COMPASS_MIN_WINDOW && sum_sq >= half * half;
+}
+
+// Did a push-off come with the current turn?
+static bool is_pushed_off() {
+  return push_off_time >= 0 && push_off_time >= turn_times[0] - COMPASS_FUSE_WINDOW;
+}
+
+// New lap: the swimming direction restarts from the headings after the turn
+static void new_lap(int64_t *turn_time) {
+  int cnt = turn_cnt;
+
+  *turn_time = turn_times[0];
+  laps_reset();
+  for (int i = 0; i < cnt; i++) {
+    window_push(turn[i]);
+  }
+}
+
+// Lap counting detection (direction change) algorithm implementation
+// Returns true when a direction change (new lap) has been detected and sets turn_time to the time
+// of the first heading of the new direction (ms), which is when the swimmer turned at the wall.
+// The new direction must last COMPASS_DURATION headings, or only COMPASS_FUSED_DURATION if the
+// accelerometer saw the push-off off the wall (see laps_push_off()).
+bool laps_detect(CompassHeadingData data, int64_t *turn_time) {
+
+    if (data.compass_status == CompassStatusDataInvalid) {
+      return false;
+    }
+    if (turn_cos == 0) {
+      turn_cos = cos_lookup(DEG_TO_TRIGANGLE(COMPASS_TURN_ANGLE)) >> UNIT_SHIFT;
+    }
+
+    Heading h = {
+      .x = cos_lookup(data.true_heading) >> UNIT_SHIFT,
+      .y = sin_lookup(data.true_heading) >> UNIT_SHIFT
+    };
+
+    if (!is_steady() || !is_turned(h)) {
+      // Still the same direction, a short turned run was just noise
+      turn_cnt = 0;
+      window_push(h);
+      return false;
+    }
+
+    turn[turn_cnt] = h;
+    turn_times[turn_cnt] = clock_ms();
+    turn_cnt++;
+
+    // APP_LOG(APP_LOG_LEVEL_INFO, "x:%d y:%d sx:%d sy:%d n:%d t:%d", h.x, h.y, (int)sum_x, (int)sum_y, window_cnt, turn_cnt);
+
+    if (turn_cnt < COMPASS_DURATION && !(turn_cnt >= COMPASS_FUSED_DURATION && is_pushed_off())) {
+      return false;
+    }
+
+    new_lap(turn_time);
+    return true;
+}
+
+// Push-off off the wall detected by the accelerometer (see turns_detect())
+// Returns true when it confirms a direction change the compass is seeing, and sets turn_time
+// like laps_detect() does.
+bool laps_push_off(int64_t push_time, int64_t *turn_time) {
+  push_off_time = push_time;
+
+  if (turn_cnt >= COMPASS_FUSED_DURATION && is_pushed_off()) {
+    new_lap(turn_time);
+    return true;
+  }
+  return false;
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+// laps detection functions prototypes
+
+// Compass tuning constants
+#define COMPASS_WINDOW 40      // headings averaged for the swimming direction (40 / 4 per sec = 10sec)
+#define COMPASS_MIN_WINDOW 12  // headings needed before a direction is trusted
+#define COMPASS_TURN_ANGLE 60  // degrees away from the swimming direction that count as turning
+#define COMPASS_DURATION 12    // headings the new direction must last to be a lap (12 / 4 per sec = 3sec)
+#define COMPASS_FUSED_DURATION 4 // or this many with a push-off off the wall (4 / 4 per sec = 1sec)
+#define COMPASS_FUSE_WINDOW 3000 // ms the push-off may come before the turned headings
+
+void laps_reset();
+bool laps_detect(CompassHeadingData data, int64_t *turn_time);
+bool laps_push_off(int64_t push_time, int64_t *turn_time);
\ No newline at end of file
@@ -0,0 +1,117 @@
+// sensor recorder code
+//
+// Opt-in recording of what the sensors saw, for tuning the detectors offline: the samples are
+// delta encoded and varint packed into fixed blocks, which are handed to DataLogging when full.
+// A swim costs about 8 bytes per accelerometer sample instead of 16. The encoding is a few
+// additions per sample, done after the detectors ran, so their timing is not disturbed.
+
+#include <pebble_worker.h>
+#include <recorder.h>
+
+static DataLoggingSessionRef s_session = NULL;
+static uint8_t s_block[RECORDER_BLOCK_SIZE];
+static int s_pos = 0;            // 0 when no block is started
+
+// Previous record of the block
+static int64_t s_last_time;
+static int16_t s_last_x, s_last_y, s_last_z;
+static int32_t s_last_heading;
+
+static uint8_t *write_varint(uint8_t *p, uint32_t value) {
+  while (value >= 0x80) {
+    *p++ = (value & 0x7f) | 0x80;
+    value >>= 7;
+  }
+  *p++ = value;
+  return p;
+}
+
+static uint32_t zigzag(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+// Hand the block over to DataLogging, padded
+static void flush_block() {
+  if (s_pos == 0) {
+    return;
+  }
+  memset(s_block + s_pos, RECORDER_END, RECORDER_BLOCK_SIZE - s_pos);
+  data_logging_log(s_session, s_block, 1);
+  s_pos = 0;
+}
+
+// Make room for a record of the given time, starting a new block if needed
+static void reserve(int64_t time) {
+  if (s_pos + RECORDER_RECORD_MAX > RECORDER_BLOCK_SIZE) {
+    flush_block();
+  }
+  if (s_pos == 0) {
+    s_block[0] = RECORDER_VERSION;
+    for (int i = 0; i < 8; i++) {
+      s_block[1 + i] = (uint64_t)time >> (8 * i);
+    }
+    s_pos = RECORDER_HEADER_SIZE;
+    s_last_time = time;
+    s_last_x = s_last_y = s_last_z = 0;
+    s_last_heading = 0;
+  }
+}
+
+void recorder_start() {
+  if (s_session == NULL) {
+    s_session = data_logging_create(RECORDER_TAG, DATA_LOGGING_BYTE_ARRAY, RECORDER_BLOCK_SIZE, true);
+    s_pos = 0;
+  }
+}
+
+void recorder_stop() {
+  if (s_session != NULL) {
+    flush_block();
+    data_logging_finish(s_session);
+    s_session = NULL;
+  }
+}
+
+bool recorder_on() {
+  return s_session != NULL;
+}
+
+// Record a batch of accelerometer samples
+void recorder_accel(AccelData *data, uint32_t num_samples) {
+  if (s_session == NULL) {
+    return;
+  }
+  for (uint32_t i = 0; i < num_samples; i++) {
+    AccelData * vector = &data[i];
+
+    reserve(vector->timestamp);
+    uint8_t *p = s_block + s_pos;
+    *p++ = RECORDER_ACCEL | (vector->did_vibrate ? RECORDER_VIBRATE : 0);
+    p = write_varint(p, zigzag((int64_t)vector->timestamp - s_last_time));
+    p = write_varint(p, zigzag(vector->x - s_last_x));
+    p = write_varint(p, zigzag(vector->y - s_last_y));
+    p = write_varint(p, zigzag(vector->z - s_last_z));
+    s_pos = p - s_block;
+
+    s_last_time = vector->timestamp;
+    s_last_x = vector->x;
+    s_last_y = vector->y;
+    s_last_z = vector->z;
+  }
+}
+
+// Record a compass reading, taken at time (ms)
+void recorder_compass(CompassHeadingData data, int64_t time) {
+  if (s_session == NULL) {
+    return;
+  }
+  reserve(time);
+  uint8_t *p = s_block + s_pos;
+  *p++ = RECORDER_COMPASS | ((data.compass_status & 0x0f) << RECORDER_STATUS_SHIFT);
+  p = write_varint(p, zigzag(time - s_last_time));
+  p = write_varint(p, zigzag((int32_t)data.true_heading - s_last_heading));
+  s_pos = p - s_block;
+
+  s_last_time = time;
+  s_last_heading = data.true_heading;
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+// sensor recorder functions prototypes
+
+// DataLogging session of the raw sensor samples (see host/decode.c)
+#define RECORDER_TAG 0x55425357  // "UBSW"
+#define RECORDER_VERSION 1
+#define RECORDER_BLOCK_SIZE 256  // bytes per DataLogging item
+
+// Block layout: version, the time of the block (uint64 ms, little endian), then records, padded
+// with RECORDER_END. Each record is a tag byte, the zigzag varint of the ms since the previous
+// record (or the block time), and:
+//   RECORDER_ACCEL: zigzag varints of x, y, z minus those of the previous sample of the block
+//   RECORDER_COMPASS: zigzag varint of the true heading (TRIG_MAX_ANGLE units) minus the previous one
+// Every block decodes on its own, the first sample of a block is a delta against 0.
+#define RECORDER_ACCEL 0x00
+#define RECORDER_COMPASS 0x01
+#define RECORDER_VIBRATE 0x10      // flag of an accel record
+#define RECORDER_STATUS_SHIFT 4    // compass status (4 bits), in the tag of a compass record
+#define RECORDER_END 0xff
+#define RECORDER_HEADER_SIZE 9
+#define RECORDER_RECORD_MAX (1 + 4 * 5)
+
+void recorder_start();
+void recorder_stop();
+bool recorder_on();
+void recorder_accel(AccelData *data, uint32_t num_samples);
+void recorder_compass(CompassHeadingData data, int64_t time);
\ No newline at end of file
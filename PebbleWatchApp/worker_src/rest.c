@@ -0,0 +1,56 @@
+// rest detection code
+
+#include <pebble_worker.h>
+#include <strokes.h>
+#include <rest.h>
+#include <dsp.h>
+
+// Stillness detection variables
+static AccelData last;          // previous sample
+static bool has_last = false;
+static int still_samples = 0;   // still samples in a row
+static uint64_t still_since;    // time of the first one (ms)
+
+// Start detecting from scratch (new workout, or back from a rest)
+void rest_reset() {
+  has_last = false;
+  still_samples = 0;
+}
+
+// Rest detection: the wrist only feels gravity and barely moves for REST_STILL_MS. Strokes, turns and
+// even the glide after a push-off never stay that still that long.
+// Returns true when a rest has been detected and sets rest_time to the time it started (ms).
+bool rest_detect(AccelData *data, uint32_t num_samples, int64_t *rest_time) {
+  bool rested = false;
+
+  for (uint32_t i = 0; i < num_samples; i++) {
+    AccelData * vector = &data[i];
+
+    if (vector->did_vibrate) {
+      continue;
+    }
+
+    int32_t sum_of_squares = dsp_magnitude_sq(vector);
+    bool still = sum_of_squares >= ACCEL_MAG_SQ_LOW && sum_of_squares <= ACCEL_MAG_SQ_HIGH && has_last &&
+                 abs(vector->x - last.x) + abs(vector->y - last.y) + abs(vector->z - last.z) < REST_JITTER;
+    last = *vector;
+    has_last = true;
+
+    if (!still) {
+      still_samples = 0;
+      continue;
+    }
+    if (still_samples == 0) {
+      still_since = vector->timestamp;
+    }
+    still_samples++;
+
+    if (still_samples == REST_STILL_SAMPLES) {
+      *rest_time = still_since;
+      still_samples = 0;
+      rested = true;
+    }
+  }
+
+  return rested;
+}
\ No newline at end of file
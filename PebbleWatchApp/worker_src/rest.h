@@ -0,0 +1,9 @@
+// rest detection functions prototypes
+
+// Stillness tuning constants
+#define REST_STILL_MS 10000  // the wrist stays still this long at the wall
+#define REST_JITTER 120      // mg, largest sample to sample change (|dx| + |dy| + |dz|) of a still wrist
+#define REST_STILL_SAMPLES ((REST_STILL_MS * ACCEL_SAMPLING_HZ + 500) / 1000)
+
+void rest_reset();
+bool rest_detect(AccelData *data, uint32_t num_samples, int64_t *rest_time);
\ No newline at end of file
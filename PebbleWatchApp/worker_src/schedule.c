@@ -0,0 +1,64 @@
+// compass scheduling code
+//
+// The compass only needs to run around the walls: right after a lap, to learn the new swimming
+// direction, and from shortly before the predicted next wall until the lap is counted. The wall
+// is predicted from the latest lap times. While the laps are irregular (or too few) the compass
+// stays on all the time.
+
+#include <pebble_worker.h>
+#include <schedule.h>
+
+// Latest lap times in ms (ring buffer)
+static uint32_t lap_durations[SCHEDULE_LAPS];
+static int laps_head = 0;
+static int laps_cnt = 0;
+
+// Start scheduling from scratch (new workout), the compass stays on until the laps are regular
+void schedule_reset() {
+  laps_head = 0;
+  laps_cnt = 0;
+}
+
+// A lap has been counted
+void schedule_lap(uint32_t lap_duration) {
+  lap_durations[laps_head] = lap_duration;
+  laps_head = (laps_head + 1) % SCHEDULE_LAPS;
+  if (laps_cnt < SCHEDULE_LAPS) {
+    laps_cnt++;
+  }
+}
+
+// The accelerometer saw a push-off off the wall while the compass was off: the prediction
+// was wrong, so keep the compass on until the laps are regular again
+void schedule_push_off() {
+  schedule_reset();
+}
+
+// Should the compass run, lap_elapsed ms into the current lap?
+bool schedule_compass_on(uint32_t lap_elapsed) {
+  if (laps_cnt < SCHEDULE_LAPS || lap_elapsed < SCHEDULE_SETTLE) {
+    return true;
+  }
+
+  uint32_t sum = 0, min = lap_durations[0], max = lap_durations[0];
+  for (int i = 0; i < SCHEDULE_LAPS; i++) {
+    sum += lap_durations[i];
+    if (lap_durations[i] < min) {
+      min = lap_durations[i];
+    }
+    if (lap_durations[i] > max) {
+      max = lap_durations[i];
+    }
+  }
+  uint32_t predicted = sum / SCHEDULE_LAPS;
+
+  if (max - min > predicted / SCHEDULE_SPREAD_DIV) {
+    return true; // irregular laps
+  }
+
+  uint32_t margin = predicted / SCHEDULE_MARGIN_DIV;
+  if (margin < SCHEDULE_MARGIN) {
+    margin = SCHEDULE_MARGIN;
+  }
+  return lap_elapsed >= (predicted > margin ? predicted - margin : 0); // unsigned, short laps keep it on
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+// compass scheduling functions prototypes
+
+// Compass duty cycling tuning constants
+#define SCHEDULE_LAPS 4        // latest lap times used to predict the next wall
+#define SCHEDULE_SETTLE 5000   // ms the compass stays on after a lap, to learn the new direction
+#define SCHEDULE_MARGIN 5000   // minimum ms the compass is turned on before the predicted wall
+#define SCHEDULE_MARGIN_DIV 5  // or 1/5 of the lap time, if longer
+#define SCHEDULE_SPREAD_DIV 4  // laps differing more than 1/4 of the lap time are irregular
+
+void schedule_reset();
+void schedule_lap(uint32_t lap_duration);
+void schedule_push_off();
+bool schedule_compass_on(uint32_t lap_elapsed);
\ No newline at end of file
@@ -0,0 +1,60 @@
+// strokes detection code
+//
+// Counts the stroke cycles on the dominant axis of the wrist, whose mean, energy and cycle the
+// stroke type classifier keeps (see stroketype.c), and the arm strokes of a cycle by stroke type.
+
+#include <pebble_worker.h>
+#include <sensing.h>
+#include <strokes.h>
+#include <stroketype.h>
+
+// Cycle counting state
+static bool high = false;       // dominant axis above its mean, with hysteresis
+static int since_cycle = 0;     // samples since the last cycle counted
+
+// Start counting from scratch (new workout, or back from a rest)
+void strokes_reset() {
+  high = false;
+  since_cycle = 0;
+  stroketype_reset();
+}
+
+// Implementation of swimming strokes detection / counting algorithm
+// The samples arrive in batches of ACCEL_SAMPLES_PER_CALLBACK, so a whole block is processed per wakeup.
+// A cycle is the dominant axis going above its mean by half the amplitude of a sine of its energy,
+// after it went as far below, no sooner than 2/3 of a cycle after the last one.
+// Returns the number of arm strokes detected in the batch, none while the stroke type is unknown.
+int strokes_detect(AccelData *data, uint32_t num_samples) {
+  const StrokeFeatures *features = stroketype_update(data, num_samples);
+  int32_t threshold = features->energy / 2; // the squared half amplitude
+  int cycles = 0;
+
+  for (uint32_t i = 0; i < num_samples; i++) {
+    AccelData * vector = &data[i];
+
+    // Skip the samples that occured during vibration
+    if (vector->did_vibrate) {
+      continue;
+    }
+    if (since_cycle < STROKETYPE_CYCLE_MAX) {
+      since_cycle++;
+    }
+
+    int32_t deviation = stroketype_axis(vector, features->axis) - features->mean;
+    if (deviation * deviation <= threshold) {
+      continue;
+    }
+    if (deviation < 0) {
+      high = false;
+    } else if (!high) {
+      high = true;
+      // OK, we have a new swimming stroke cycle here! Log it!
+      if (features->type != STROKE_UNKNOWN && since_cycle * 3 >= features->cycle * 2) {
+        cycles++;
+        since_cycle = 0;
+      }
+    }
+  }
+
+  return cycles * STROKETYPE_PULLS(features->type);
+}
\ No newline at end of file
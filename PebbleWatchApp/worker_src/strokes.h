@@ -0,0 +1,22 @@
+// strokes detection functions prototypes
+
+// Accelerometer tuning constants 
+// one of 10, 25, 50, 100 (the AccelSamplingRate values), the windows of the detectors are in ms and
+// grow with it. The M4 of basalt runs their kernels twice as fast (see dsp.h).
+#ifdef PBL_PLATFORM_BASALT
+#define ACCEL_SAMPLING_HZ 50
+#else
+#define ACCEL_SAMPLING_HZ 25
+#endif
+#define ACCEL_SAMPLING_RATE ((AccelSamplingRate)ACCEL_SAMPLING_HZ)
+#define ACCEL_SAMPLES_PER_CALLBACK 25 // batch size (max 25): 1 wakeup per second at 25Hz, 2 at 50Hz (basalt)
+#define ACCEL_GRAVITY 1000 // 1g in mg, the magnitude of the acceleration at rest
+#define ACCEL_THRESHOLD 180    // mg, off gravity: the wrist moves (see turns.c and rest.c)
+
+// The test |ACCEL_GRAVITY - sqrt(x*x + y*y + z*z)| > ACCEL_THRESHOLD is done on the squared
+// magnitude against these squared bounds, so there is no float or sqrt in the per sample path.
+#define ACCEL_MAG_SQ_LOW ((ACCEL_GRAVITY - ACCEL_THRESHOLD) * (ACCEL_GRAVITY - ACCEL_THRESHOLD))
+#define ACCEL_MAG_SQ_HIGH ((ACCEL_GRAVITY + ACCEL_THRESHOLD) * (ACCEL_GRAVITY + ACCEL_THRESHOLD))
+
+void strokes_reset();
+int strokes_detect(AccelData *data, uint32_t num_samples);
\ No newline at end of file
@@ -0,0 +1,166 @@
+// stroke type classification code
+//
+// Labels the stroke type from integer features of the last STROKETYPE_WINDOW samples, in a static
+// window that slides by one batch per wakeup: no heap, no float, and O(window * cycle range)
+// multiply-adds per batch (see dsp.c). The wrist frame is x along the forearm, y across it, z out
+// of the face.
+//   - energy of each axis around its mean, the dominant axis has the most
+//   - periodicity: the first autocorrelation peak of the dominant axis is the stroke cycle
+//   - rotation: freestyle, backstroke and butterfly recover the arm over the water, which turns
+//     gravity around the wrist in the x-z plane, forward or backward. Breaststroke stays in front.
+//   - lateral energy: the wide sweep of both arms of butterfly
+
+#include <pebble_worker.h>
+#include <sensing.h>
+#include <strokes.h>
+#include <stroketype.h>
+#include <dsp.h>
+
+// The last samples of each axis, oldest first
+static int16_t s_window[3][STROKETYPE_WINDOW];
+static int s_count = 0;
+static StrokeFeatures s_features;
+// Deviations of an axis from its mean, oldest first
+static int16_t s_deviations[STROKETYPE_WINDOW];
+
+// Start classifying from scratch (new workout, or back from a rest)
+void stroketype_reset() {
+  s_count = 0;
+  memset(&s_features, 0, sizeof(s_features));
+}
+
+int16_t stroketype_axis(AccelData *vector, int axis) {
+  return axis == 0 ? vector->x : (axis == 1 ? vector->y : vector->z);
+}
+
+// Slide the window over the samples of a batch, skipping those that occured during vibration
+static void window_push(AccelData *data, uint32_t num_samples) {
+  int n = 0;
+  for (uint32_t i = 0; i < num_samples; i++) {
+    if (!data[i].did_vibrate) {
+      n++;
+    }
+  }
+  int skip = n > STROKETYPE_WINDOW ? n - STROKETYPE_WINDOW : 0;
+  int keep = STROKETYPE_WINDOW - (n - skip);
+  if (keep > s_count) {
+    keep = s_count;
+  }
+
+  for (int axis = 0; axis < 3; axis++) {
+    memmove(s_window[axis], s_window[axis] + s_count - keep, keep * sizeof(int16_t));
+  }
+  s_count = keep;
+
+  for (uint32_t i = 0; i < num_samples; i++) {
+    if (data[i].did_vibrate || skip-- > 0) {
+      continue;
+    }
+    s_window[0][s_count] = data[i].x;
+    s_window[1][s_count] = data[i].y;
+    s_window[2][s_count] = data[i].z;
+    s_count++;
+  }
+}
+
+static int32_t sum_of(const int16_t *v) {
+  int32_t sum = 0;
+  for (int i = 0; i < s_count; i++) {
+    sum += v[i];
+  }
+  return sum;
+}
+
+// Load the deviations of an axis from its mean
+static void load_deviations(const int16_t *v, int32_t mean) {
+  for (int i = 0; i < s_count; i++) {
+    s_deviations[i] = v[i] - mean;
+  }
+}
+
+// Mean product of the deviations lag samples apart, the energy at lag 0
+static int32_t autocorrelation(int lag) {
+  return dsp_dot16(s_deviations + lag, s_deviations, s_count - lag) / (s_count - lag);
+}
+
+// Stroke cycle of the loaded axis: the first autocorrelation peak above STROKETYPE_PERIODIC % of
+// the energy, the later ones are its multiples. 0 when not periodic.
+static int find_cycle(int32_t energy) {
+  int last_lag = s_count - s_count / 4;
+  if (last_lag > STROKETYPE_CYCLE_MAX) {
+    last_lag = STROKETYPE_CYCLE_MAX;
+  }
+  int32_t before = autocorrelation(STROKETYPE_CYCLE_MIN - 1);
+  int32_t at = autocorrelation(STROKETYPE_CYCLE_MIN);
+
+  for (int lag = STROKETYPE_CYCLE_MIN; lag < last_lag; lag++) {
+    int32_t after = autocorrelation(lag + 1);
+    if (at >= before && at > after && (int64_t)at * 100 >= (int64_t)energy * STROKETYPE_PERIODIC) {
+      return lag;
+    }
+    before = at;
+    at = after;
+  }
+  return 0;
+}
+
+// Add a batch of samples and classify the window. The features stay valid until the next batch.
+const StrokeFeatures *stroketype_update(AccelData *data, uint32_t num_samples) {
+  int32_t mean[3], energy[3];
+
+  window_push(data, num_samples);
+  s_features.type = STROKE_UNKNOWN;
+  s_features.cycle = 0;
+  if (s_count < STROKETYPE_CYCLE_MAX + STROKETYPE_CYCLE_MIN) {
+    return &s_features; // not a cycle and its echo yet
+  }
+
+  int axis = 0;
+  for (int i = 0; i < 3; i++) {
+    mean[i] = sum_of(s_window[i]) / s_count;
+    load_deviations(s_window[i], mean[i]);
+    energy[i] = autocorrelation(0);
+    if (energy[i] > energy[axis]) {
+      axis = i;
+    }
+  }
+  s_features.axis = axis;
+  s_features.mean = mean[axis];
+  s_features.energy = energy[axis];
+  if (energy[axis] < STROKETYPE_MIN_ENERGY) {
+    return &s_features;
+  }
+
+  if (axis != 2) {
+    load_deviations(s_window[axis], mean[axis]);
+  }
+  s_features.cycle = find_cycle(energy[axis]);
+  if (s_features.cycle == 0) {
+    return &s_features;
+  }
+
+  // Direction the forearm turns in the x-z plane: the sum of the cross products of the
+  // successive deviations, (x[i-1] - mx) * (z[i] - mz) - (z[i-1] - mz) * (x[i] - mx), which
+  // expands to the products of the samples and a correction of the ends
+  const int16_t *x = s_window[0], *z = s_window[2];
+  int last = s_count - 1;
+  int64_t rotation = dsp_dot16(x, z + 1, last) - dsp_dot16(z, x + 1, last) +
+                     mean[2] * (x[last] - x[0]) + mean[0] * (z[0] - z[last]);
+
+  int64_t sweep = (int64_t)energy[0] + energy[2];
+  if (sweep * 100 < (int64_t)STROKETYPE_ROTATION * ACCEL_GRAVITY * ACCEL_GRAVITY) {
+    s_features.type = STROKE_BREAST;
+  } else if (rotation < 0) {
+    s_features.type = STROKE_BACK;
+  } else if ((int64_t)energy[1] * 100 > (sweep + energy[1]) * STROKETYPE_LATERAL) {
+    s_features.type = STROKE_FLY;
+  } else {
+    s_features.type = STROKE_FREE;
+  }
+  return &s_features;
+}
+
+// Stroke type of the last batch
+StrokeType stroketype_current() {
+  return s_features.type;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+// stroke type classification functions prototypes (include sensing.h and strokes.h first)
+
+// Classification tuning constants
+#define STROKETYPE_WINDOW_MS 3840     // long enough for a slow breaststroke cycle and its echo
+#define STROKETYPE_WINDOW ((STROKETYPE_WINDOW_MS * ACCEL_SAMPLING_HZ + 500) / 1000) // in samples, 96 @ 25Hz
+#define STROKETYPE_CYCLE_MIN_MS 600   // fastest stroke cycle, a sprint
+#define STROKETYPE_CYCLE_MAX_MS 2800  // slowest, a long breaststroke glide
+#define STROKETYPE_CYCLE_MIN ((STROKETYPE_CYCLE_MIN_MS * ACCEL_SAMPLING_HZ + 500) / 1000)
+#define STROKETYPE_CYCLE_MAX ((STROKETYPE_CYCLE_MAX_MS * ACCEL_SAMPLING_HZ + 500) / 1000)
+#define STROKETYPE_MIN_ENERGY 20000   // mg², least energy of the dominant axis while swimming
+#define STROKETYPE_PERIODIC 40        // %, least autocorrelation at the cycle (of the energy)
+#define STROKETYPE_ROTATION 25        // %, least x and z energy (of 1g²) of an arm recovering over the water
+#define STROKETYPE_LATERAL 5          // %, least y energy (of all axes) of the butterfly sweep
+
+// Arm strokes per cycle: one per arm of the alternating strokes, both arms pull at once otherwise
+#define STROKETYPE_PULLS(type) ((type) == STROKE_BREAST || (type) == STROKE_FLY ? 1 : 2)
+
+// Features of the sample window, updated once per accelerometer batch
+typedef struct {
+  StrokeType type;     // STROKE_UNKNOWN when not swimming (glide, turn, rest)
+  int axis;            // dominant axis: 0 x, 1 y, 2 z
+  int32_t mean;        // of the dominant axis (mg)
+  int32_t energy;      // mean squared deviation of the dominant axis (mg²)
+  int cycle;           // stroke cycle (samples), 0 when not periodic
+} StrokeFeatures;
+
+void stroketype_reset();
+const StrokeFeatures *stroketype_update(AccelData *data, uint32_t num_samples);
+StrokeType stroketype_current();
+int16_t stroketype_axis(AccelData *vector, int axis);
\ No newline at end of file
@@ -0,0 +1,87 @@
+// stroke rate (tempo) estimation code
+//
+// Estimates the stroke cycle from the autocorrelation of the acceleration magnitude over the last
+// TEMPO_WINDOW samples, once per accelerometer batch. The magnitude does not depend on how the
+// watch is turned, nor on any per-stroke threshold, so the rate cross-checks the stroke counter
+// (see strokes.c). All integer: a ring buffer of int16 magnitudes, unrolled once per batch into their
+// deviations from the mean for the multiply-adds, and the best lag refined to
+// 1/256 sample by a parabola through its neighbours. The cost is bounded by
+// TEMPO_WINDOW * (TEMPO_CYCLE_MAX - TEMPO_CYCLE_MIN) multiply-adds per batch.
+
+#include <pebble_worker.h>
+#include <common.h>
+#include <strokes.h>
+#include <tempo.h>
+#include <dsp.h>
+
+// Ring buffer of the last magnitudes (mg)
+static int16_t s_magnitudes[TEMPO_WINDOW];
+static int s_head = 0;  // next slot to write
+static int s_count = 0;
+// Deviations of the magnitudes from their mean, oldest first
+static int16_t s_deviations[TEMPO_WINDOW];
+
+// Start estimating from scratch (new workout, or back from a rest)
+void tempo_reset() {
+  s_head = 0;
+  s_count = 0;
+}
+
+// The i-th magnitude kept, 0 is the oldest one
+static inline int32_t magnitude(int i) {
+  return s_magnitudes[(s_head - s_count + i) & (TEMPO_WINDOW - 1)];
+}
+
+// Mean product of the deviations lag samples apart, the energy at lag 0
+static int32_t autocorrelation(int lag) {
+  return dsp_dot16(s_deviations + lag, s_deviations, s_count - lag) / (s_count - lag);
+}
+
+// Add a batch of samples and estimate the stroke cycle.
+// Returns the cycle period in 1/256 samples, or 0 when the magnitude is not periodic (not swimming).
+int32_t tempo_update(AccelData *data, uint32_t num_samples) {
+  for (uint32_t i = 0; i < num_samples; i++) {
+    AccelData * vector = &data[i];
+
+    if (vector->did_vibrate) {
+      continue;
+    }
+    s_magnitudes[s_head] = isqrt(dsp_magnitude_sq(vector));
+    s_head = (s_head + 1) & (TEMPO_WINDOW - 1);
+    if (s_count < TEMPO_WINDOW) {
+      s_count++;
+    }
+  }
+  if (s_count < TEMPO_WINDOW) {
+    return 0;
+  }
+
+  int32_t sum = 0;
+  for (int i = 0; i < s_count; i++) {
+    sum += magnitude(i);
+  }
+  int32_t mean = sum / s_count;
+  for (int i = 0; i < s_count; i++) {
+    s_deviations[i] = magnitude(i) - mean;
+  }
+  int32_t energy = autocorrelation(0);
+  if (energy < TEMPO_MIN_ENERGY) {
+    return 0;
+  }
+
+  // The first autocorrelation peak above TEMPO_PERIODIC % of the energy, the later ones are its multiples
+  int32_t before = autocorrelation(TEMPO_CYCLE_MIN - 1);
+  int32_t at = autocorrelation(TEMPO_CYCLE_MIN);
+  for (int lag = TEMPO_CYCLE_MIN; lag < TEMPO_CYCLE_MAX; lag++) {
+    int32_t after = autocorrelation(lag + 1);
+    if (at >= before && at > after && (int64_t)at * 100 >= (int64_t)energy * TEMPO_PERIODIC) {
+      // Vertex of the parabola through the three points
+      int32_t curve = before - 2 * at + after;
+      int32_t offset = curve < 0 ? (int32_t)(((int64_t)(before - after) * 128) / curve) : 0;
+      return lag * 256 + offset;
+    }
+    before = at;
+    at = after;
+  }
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+// stroke rate (tempo) estimation functions prototypes (include strokes.h first)
+
+// Tempo tuning constants
+// samples of magnitude kept, a power of 2: 5.1s
+#ifdef PBL_PLATFORM_BASALT
+#define TEMPO_WINDOW 256
+#else
+#define TEMPO_WINDOW 128
+#endif
+#define TEMPO_CYCLE_MIN_MS 600    // fastest stroke cycle, 100 cycles/min
+#define TEMPO_CYCLE_MAX_MS 2800   // slowest, 21 cycles/min
+#define TEMPO_CYCLE_MIN ((TEMPO_CYCLE_MIN_MS * ACCEL_SAMPLING_HZ + 500) / 1000)
+#define TEMPO_CYCLE_MAX ((TEMPO_CYCLE_MAX_MS * ACCEL_SAMPLING_HZ + 500) / 1000)
+#define TEMPO_MIN_ENERGY 10000    // mg², least magnitude energy while swimming
+#define TEMPO_PERIODIC 40         // %, least autocorrelation at the cycle (of the energy)
+
+// Cycle period of tempo_update() in 1/256 samples to cycles (times per_cycle) per minute
+#define TEMPO_PER_MINUTE(period, per_cycle) \
+  ((period) > 0 ? (60 * ACCEL_SAMPLING_HZ * 256 * (per_cycle) + (period) / 2) / (period) : 0)
+
+void tempo_reset();
+int32_t tempo_update(AccelData *data, uint32_t num_samples);
\ No newline at end of file
@@ -0,0 +1,67 @@
+// wall turns detection code
+
+#include <pebble_worker.h>
+#include <strokes.h>
+#include <turns.h>
+#include <dsp.h>
+
+#define ACCEL_PUSH_SQ (ACCEL_PUSH_THRESHOLD * ACCEL_PUSH_THRESHOLD)
+
+// Push-off detection variables
+static bool pushing = false;      // a kick has been seen, waiting for the glide
+static uint64_t push_timestamp;   // time of the kick (ms)
+static int push_samples = 0;      // samples since the kick
+static int glide_samples = 0;     // quiet samples in a row since the kick
+
+// Start detecting from scratch (new workout)
+void turns_reset() {
+  pushing = false;
+  push_samples = 0;
+  glide_samples = 0;
+}
+
+// Wall push-off detection: a kick well above ACCEL_PUSH_THRESHOLD followed by a glide, a stretch of
+// ACCEL_GLIDE_MS with no stroke activity. The tumble of a turn and the strokes never go quiet that long.
+// Returns true when a push-off has been detected and sets push_time to the time of the kick (ms).
+bool turns_detect(AccelData *data, uint32_t num_samples, int64_t *push_time) {
+  bool pushed = false;
+
+  for (uint32_t i = 0; i < num_samples; i++) {
+    AccelData * vector = &data[i];
+
+    if (vector->did_vibrate) {
+      continue;
+    }
+
+    int32_t sum_of_squares = dsp_magnitude_sq(vector);
+
+    if (sum_of_squares > ACCEL_PUSH_SQ) {
+      // A (new) kick
+      pushing = true;
+      push_timestamp = vector->timestamp;
+      push_samples = 0;
+      glide_samples = 0;
+      continue;
+    }
+    if (!pushing) {
+      continue;
+    }
+
+    push_samples++;
+    if (sum_of_squares >= ACCEL_MAG_SQ_LOW && sum_of_squares <= ACCEL_MAG_SQ_HIGH) {
+      glide_samples++;
+    } else if (push_samples > ACCEL_PUSH_SAMPLES) {
+      pushing = false; // moving again without a glide, it wasn't a push-off
+    } else {
+      glide_samples = 0;
+    }
+
+    if (pushing && glide_samples == ACCEL_GLIDE_SAMPLES) {
+      *push_time = push_timestamp;
+      pushing = false;
+      pushed = true;
+    }
+  }
+
+  return pushed;
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+// wall turns detection functions prototypes
+
+// Push-off tuning constants
+#define ACCEL_PUSH_THRESHOLD 2000 // mg, the kick off the wall
+#define ACCEL_PUSH_MS 400         // the kick may last this long before the glide
+#define ACCEL_GLIDE_MS 400        // quiet time (no strokes) after the kick
+#define ACCEL_PUSH_SAMPLES ((ACCEL_PUSH_MS * ACCEL_SAMPLING_HZ + 500) / 1000)
+#define ACCEL_GLIDE_SAMPLES ((ACCEL_GLIDE_MS * ACCEL_SAMPLING_HZ + 500) / 1000)
+
+void turns_reset();
+bool turns_detect(AccelData *data, uint32_t num_samples, int64_t *push_time);
\ No newline at end of file
@@ -0,0 +1,319 @@
+// UbiSwim background worker
+//
+// Counts the strokes and laps from the accelerometer and the compass while the workout runs,
+// whether the app is on screen or not. The app starts and pauses it and only renders the counters
+// it receives: one SENSING_COUNTS message per accelerometer batch that changed them, one
+// SENSING_LAP message per lap, and a SENSING_TEMPO message when the stroke rate changes
+// (see src/sensing.h). The messages sent while the app is closed are lost, so the last laps are
+// also logged and sent again when the app syncs on reopening.
+//
+// When the swimmer rests at the wall the sensors are turned off and only the accelerometer tap
+// service is kept on: the push-off of the next set wakes the worker up. The app pauses the
+// stopwatch in the meantime (SENSING_REST / SENSING_RESUME).
+
+#include <pebble_worker.h>
+#include <common.h>
+#include <sensing.h>
+#include <strokes.h>
+#include <stroketype.h>
+#include <tempo.h>
+#include <laps.h>
+#include <turns.h>
+#include <schedule.h>
+#include <rest.h>
+#include <recorder.h>
+
+static bool running = false;        // counting, started by the app
+static bool resting = false;        // sensors off until a tap, while running
+static bool compass_running = false;
+static int64_t lap_start_time = 0;  // clock_ms(), moved forward by the pauses
+static int64_t pause_time = 0;      // of the last pause or rest
+static uint32_t rested_ms = 0;      // of the rests ended by a push-off, see SENSING_RESTED_MS
+
+// Counters
+static int strokes = 0;
+static int laps = 0;
+static int strokes_of_lap = 0;
+static int type_strokes[STROKE_TYPES]; // strokes of the lap by stroke type
+static bool counts_changed = false;
+static int stroke_rate = 0;  // strokes per minute, last sent
+
+// Log of the last laps, replayed to the app on SENSING_SYNC
+typedef struct {
+  uint16_t number;
+  uint16_t duration_ds;  // 1/10 s
+  uint16_t data2;        // SENSING_LAP_DATA2
+} LoggedLap;
+
+static LoggedLap lap_log[SENSING_LAP_LOG];
+static int lap_log_count = 0;
+
+// Function prototypes
+static void accelerometer_handler(AccelData*, uint32_t);
+static void compass_handler(CompassHeadingData);
+static void tap_handler(AccelAxisType, int32_t);
+static void start_rest(int64_t);
+
+static void send_message(uint8_t type, uint16_t data0, uint16_t data1, uint16_t data2) {
+  AppWorkerMessage message = { .data0 = data0, .data1 = data1, .data2 = data2 };
+  app_worker_send_message(type, &message);
+}
+
+static void send_rested(uint8_t type, uint16_t data0) {
+  uint32_t rested = rested_ms + (resting ? clock_ms() - pause_time : 0);
+  send_message(type, data0, rested & 0xffff, rested >> 16);
+}
+
+static void send_counts() {
+  send_message(SENSING_COUNTS, strokes, laps, strokes_of_lap);
+  counts_changed = false;
+}
+
+static void send_stroke_rate(int rate) {
+  if (rate != stroke_rate) {
+    stroke_rate = rate;
+    send_message(SENSING_TEMPO, rate, 0, 0);
+  }
+}
+
+static void start_compass() {
+  compass_service_subscribe(compass_handler);
+  compass_service_set_heading_filter(TRIG_MAX_ANGLE / 72); // 360 / 72 = 5 degrees (diff to trigger compass read)
+  compass_running = true;
+}
+
+static void stop_compass() {
+  compass_service_unsubscribe();
+  compass_running = false;
+}
+
+// Run the compass only around the predicted walls (see schedule.c)
+static void schedule_compass() {
+  bool on = schedule_compass_on(clock_ms() - lap_start_time);
+
+  if (on && !compass_running) {
+    start_compass();
+  } else if (!on && compass_running) {
+    stop_compass();
+  }
+}
+
+// Stroke type of the lap: the one most of its strokes were classified as
+static StrokeType lap_stroke_type() {
+  StrokeType type = STROKE_UNKNOWN;
+  for (int i = STROKE_FREE; i < STROKE_TYPES; i++) {
+    if (type_strokes[i] > type_strokes[type]) {
+      type = i;
+    }
+  }
+  return type;
+}
+
+// Count a new lap, that ended when the swimmer turned at the wall
+static void count_lap(int64_t turn_time) {
+  if (turn_time < lap_start_time) {
+    turn_time = lap_start_time; // the turn started before a pause
+  }
+  int64_t ago = clock_ms() - turn_time;
+
+  int64_t duration_ds = (turn_time - lap_start_time + 50) / 100;
+
+  laps++;
+  LoggedLap *logged = &lap_log[laps % SENSING_LAP_LOG];
+  logged->number = laps;
+  logged->duration_ds = duration_ds < UINT16_MAX ? duration_ds : UINT16_MAX;
+  logged->data2 = SENSING_LAP_DATA2(strokes_of_lap, lap_stroke_type());
+  if (lap_log_count < SENSING_LAP_LOG) {
+    lap_log_count++;
+  }
+  send_message(SENSING_LAP, laps, ago < UINT16_MAX ? ago : UINT16_MAX, logged->data2);
+  schedule_lap(turn_time - lap_start_time);
+
+  strokes_of_lap = 0;
+  memset(type_strokes, 0, sizeof(type_strokes));
+  lap_start_time = turn_time;
+  counts_changed = true;
+}
+
+// Count the swimming strokes (and the wall push-offs) of a batch of accelerometer samples
+static void accelerometer_handler(AccelData *data, uint32_t num_samples) {
+  int64_t push_time, turn_time;
+
+  int new_strokes = strokes_detect(data, num_samples);
+  if (new_strokes > 0) {
+    strokes += new_strokes;
+    strokes_of_lap += new_strokes; // strokes of current lap to calculate the SWOLF score of the lap
+    type_strokes[stroketype_current()] += new_strokes;
+    counts_changed = true;
+  }
+
+  // A push-off confirms the turn the compass is seeing, without waiting for the new direction to settle
+  if (turns_detect(data, num_samples, &push_time)) {
+    if (!compass_running) {
+      schedule_push_off(); // the wall came before the predicted one, turn the compass back on
+    }
+    if (laps_push_off(push_time, &turn_time)) {
+      count_lap(turn_time);
+    }
+  }
+
+  // The counters of the whole batch go in one message
+  if (counts_changed) {
+    send_counts();
+  }
+
+  int32_t period = tempo_update(data, num_samples);
+  send_stroke_rate(TEMPO_PER_MINUTE(period, STROKETYPE_PULLS(stroketype_current())));
+
+  int64_t rest_time;
+  if (rest_detect(data, num_samples, &rest_time)) {
+    start_rest(rest_time);
+  } else {
+    schedule_compass();
+  }
+
+  // Last, not to delay the detection
+  recorder_accel(data, num_samples);
+}
+
+// Count the laps on compass direction changes
+static void compass_handler(CompassHeadingData data) {
+  int64_t turn_time;
+
+  if (laps_detect(data, &turn_time)) {
+    count_lap(turn_time);
+    send_counts();
+  }
+
+  recorder_compass(data, clock_ms());
+}
+
+static void start_sensors() {
+  accel_service_set_sampling_rate( ACCEL_SAMPLING_RATE );
+  accel_data_service_subscribe( ACCEL_SAMPLES_PER_CALLBACK, accelerometer_handler );
+  start_compass();
+}
+
+static void stop_sensors() {
+  accel_data_service_unsubscribe();
+  stop_compass();
+}
+
+// The swimmer stands still since rest_time: keep only the tap service on until the next push-off
+static void start_rest(int64_t rest_time) {
+  int64_t ago = clock_ms() - rest_time;
+
+  stop_sensors();
+  accel_tap_service_subscribe(tap_handler);
+  resting = true;
+  pause_time = rest_time;
+  stroke_rate = 0; // the app drops it on rest
+  send_message(SENSING_REST, ago < UINT16_MAX ? ago : UINT16_MAX, 0, 0);
+}
+
+static void stop_rest() {
+  accel_tap_service_unsubscribe();
+  resting = false;
+}
+
+// Moving again after a rest (the push-off of the next set), the rest does not count in the lap time
+static void tap_handler(AccelAxisType axis, int32_t direction) {
+  stop_rest();
+  lap_start_time += clock_ms() - pause_time;
+  rested_ms += clock_ms() - pause_time;
+  strokes_reset();
+  turns_reset();
+  rest_reset();
+  tempo_reset();
+  start_sensors();
+  send_rested(SENSING_RESUME, 0);
+}
+
+// Send again the logged laps the app has not counted, oldest first
+static void send_logged_laps(int app_laps) {
+  for (int number = laps - lap_log_count + 1; number <= laps; number++) {
+    const LoggedLap *logged = &lap_log[number % SENSING_LAP_LOG];
+    if (number > app_laps && logged->number == number) {
+      send_message(SENSING_LAP_LOGGED, logged->number, logged->duration_ds, logged->data2);
+    }
+  }
+}
+
+static void start_counting(AppWorkerMessage *data) {
+  strokes = data->data0;
+  laps = data->data1;
+  strokes_of_lap = data->data2;
+  if (running) {
+    return;
+  }
+
+  if (pause_time != 0) {
+    lap_start_time += clock_ms() - pause_time;
+  } else {
+    lap_start_time = clock_ms();
+  }
+  running = true;
+  rest_reset();
+  tempo_reset();
+  stroke_rate = 0; // the app drops it on pause
+  start_sensors();
+}
+
+static void pause_counting() {
+  if (!running) {
+    return;
+  }
+  running = false;
+  if (resting) {
+    stop_rest(); // paused since the rest started
+    return;
+  }
+  stop_sensors();
+  pause_time = clock_ms();
+}
+
+// Messages from the app
+static void app_message_handler(uint16_t type, AppWorkerMessage *data) {
+  switch (type) {
+    case SENSING_START:
+      start_counting(data);
+      break;
+    case SENSING_PAUSE:
+      pause_counting();
+      break;
+    case SENSING_SYNC:
+      send_logged_laps(data->data1);
+      send_counts();
+      send_rested(SENSING_SYNCED, !running ? SENSING_PAUSED : resting ? SENSING_RESTING : SENSING_RUNNING);
+      break;
+    case SENSING_RECORD:
+      if (data->data0) {
+        recorder_start();
+      } else {
+        recorder_stop();
+      }
+      break;
+  }
+}
+
+static void init() {
+  strokes_reset();
+  turns_reset();
+  laps_reset();
+  schedule_reset();
+  rest_reset();
+  app_worker_message_subscribe(app_message_handler);
+  send_message(SENSING_READY, 0, 0, 0);
+}
+
+static void deinit() {
+  pause_counting();
+  recorder_stop();
+  app_worker_message_unsubscribe();
+}
+
+int main(void) {
+  init();
+  worker_event_loop();
+  deinit();
+}
\ No newline at end of file